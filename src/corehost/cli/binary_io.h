@@ -0,0 +1,169 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __BINARY_IO_H_
+#define __BINARY_IO_H_
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include "pal.h"
+
+// -----------------------------------------------------------------------------
+// Appends the fields of a binary host file to a byte buffer.
+//
+class binary_writer_t
+{
+public:
+    explicit binary_writer_t(std::string* out)
+        : m_out(*out)
+    {
+    }
+
+    void write_u32(uint32_t value)
+    {
+        m_out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void write_u64(uint64_t value)
+    {
+        m_out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void write_bytes(const std::string& value)
+    {
+        write_u32((uint32_t) value.size());
+        m_out.append(value);
+    }
+
+    void write_string(const pal::string_t& value)
+    {
+        write_u32((uint32_t) value.size());
+        m_out.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(pal::char_t));
+    }
+
+    void write_strings(const std::vector<pal::string_t>& values)
+    {
+        write_u32((uint32_t) values.size());
+        for (const auto& value : values)
+        {
+            write_string(value);
+        }
+    }
+
+private:
+    std::string& m_out;
+};
+
+// -----------------------------------------------------------------------------
+// Reads the fields of a binary host file. Every read checks the bounds of the
+// buffer, so a truncated or corrupt file fails to read instead of crashing.
+//
+class binary_reader_t
+{
+public:
+    binary_reader_t(const char* begin, const char* end)
+        : m_pos(begin)
+        , m_end(end)
+    {
+    }
+
+    bool read_u32(uint32_t* value)
+    {
+        return read_raw(value, sizeof(*value));
+    }
+
+    bool read_u64(uint64_t* value)
+    {
+        return read_raw(value, sizeof(*value));
+    }
+
+    bool read_bytes(std::string* value)
+    {
+        uint32_t size;
+        if (!read_u32(&size) || (size_t) (m_end - m_pos) < size)
+        {
+            return false;
+        }
+        value->assign(m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    bool read_string(pal::string_t* value)
+    {
+        uint32_t size;
+        if (!read_u32(&size) || (size_t) (m_end - m_pos) / sizeof(pal::char_t) < size)
+        {
+            return false;
+        }
+        value->resize(size);
+        if (size > 0)
+        {
+            memcpy(&(*value)[0], m_pos, size * sizeof(pal::char_t));
+        }
+        m_pos += size * sizeof(pal::char_t);
+        return true;
+    }
+
+    // The bytes of a string in the buffer, without copying them.
+    bool read_string_bytes(const char** bytes, size_t* size)
+    {
+        uint32_t length;
+        if (!read_u32(&length) || (size_t) (m_end - m_pos) / sizeof(pal::char_t) < length)
+        {
+            return false;
+        }
+        *bytes = m_pos;
+        *size = length * sizeof(pal::char_t);
+        m_pos += *size;
+        return true;
+    }
+
+    bool read_strings(std::vector<pal::string_t>* values)
+    {
+        uint32_t count;
+        if (!read_count(&count))
+        {
+            return false;
+        }
+        values->resize(count);
+        for (auto& value : *values)
+        {
+            if (!read_string(&value))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A count of items, each of which takes at least four bytes.
+    bool read_count(uint32_t* count)
+    {
+        return read_u32(count) && (size_t) (m_end - m_pos) / sizeof(uint32_t) >= *count;
+    }
+
+    bool at_end() const
+    {
+        return m_pos == m_end;
+    }
+
+private:
+    bool read_raw(void* value, size_t size)
+    {
+        if ((size_t) (m_end - m_pos) < size)
+        {
+            return false;
+        }
+        memcpy(value, m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    const char* m_pos;
+    const char* m_end;
+};
+
+#endif // __BINARY_IO_H_
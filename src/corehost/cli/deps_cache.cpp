@@ -0,0 +1,220 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "deps_cache.h"
+#include "binary_io.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+const uint32_t s_cache_magic = 0x43535044; // "DPSC"
+const uint32_t s_cache_version = 1;
+
+bool read_document(binary_reader_t* reader, bool portable, deps_document_t* document)
+{
+    uint32_t magic, version, char_size, cached_portable, count;
+    if (!reader->read_u32(&magic) || magic != s_cache_magic ||
+        !reader->read_u32(&version) || version != s_cache_version ||
+        !reader->read_u32(&char_size) || char_size != sizeof(pal::char_t) ||
+        !reader->read_u32(&cached_portable) || cached_portable != (portable ? 1 : 0))
+    {
+        return false;
+    }
+
+    if (!reader->read_u64(&document->hash) || !reader->read_string(&document->target_name))
+    {
+        return false;
+    }
+
+    if (!reader->read_count(&count))
+    {
+        return false;
+    }
+    document->targets.resize(count);
+    for (auto& entry : document->targets)
+    {
+        if (!reader->read_string(&entry.name) || !reader->read_u64(&entry.hash))
+        {
+            return false;
+        }
+        for (auto& assets : entry.assets)
+        {
+            if (!reader->read_strings(&assets))
+            {
+                return false;
+            }
+        }
+        if (!reader->read_count(&count))
+        {
+            return false;
+        }
+        entry.rid_assets.resize(count);
+        for (auto& rid_asset : entry.rid_assets)
+        {
+            uint32_t asset_type;
+            if (!reader->read_string(&rid_asset.rid) || !reader->read_u32(&asset_type) ||
+                asset_type >= deps_entry_t::asset_types::count || !reader->read_string(&rid_asset.rel_path))
+            {
+                return false;
+            }
+            rid_asset.asset_type = (int) asset_type;
+        }
+    }
+
+    uint32_t has_libraries;
+    if (!reader->read_u32(&has_libraries) || !reader->read_count(&count))
+    {
+        return false;
+    }
+    document->has_libraries = (has_libraries != 0);
+    document->libraries.resize(count);
+    for (auto& entry : document->libraries)
+    {
+        uint32_t serviceable;
+        if (!reader->read_string(&entry.name) || !reader->read_u64(&entry.hash) ||
+            !reader->read_string(&entry.type) || !reader->read_string(&entry.sha512) ||
+            !reader->read_u32(&serviceable) || !reader->read_bytes(&entry.error))
+        {
+            return false;
+        }
+        entry.serviceable = (serviceable != 0);
+    }
+
+    if (!reader->read_u64(&document->runtimes_hash) || !reader->read_count(&count))
+    {
+        return false;
+    }
+    document->runtimes.resize(count);
+    for (auto& rid : document->runtimes)
+    {
+        if (!reader->read_string(&rid.first) || !reader->read_strings(&rid.second))
+        {
+            return false;
+        }
+    }
+
+    return reader->at_end();
+}
+} // end of anonymous namespace
+
+// -----------------------------------------------------------------------------
+// A fast, non-cryptographic hash to tell whether the JSON text of a deps file
+// or of one of its entries changed.
+//
+uint64_t deps_cache::hash(const char* data, size_t size)
+{
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+    uint64_t hash = 0xCBF29CE484222325ULL ^ size;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i)
+    {
+        hash = (hash ^ (unsigned char) data[i]) * multiplier;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+bool deps_cache::get_cache_file(const pal::string_t& deps_path, pal::string_t* cache_file)
+{
+    pal::string_t cache_dir;
+    if (!get_host_cache_dir(&cache_dir))
+    {
+        return false;
+    }
+
+    pal::stringstream_t name;
+    name << std::hex << hash(reinterpret_cast<const char*>(deps_path.data()), deps_path.size() * sizeof(pal::char_t)) << _X(".deps.cache");
+
+    cache_file->assign(cache_dir);
+    append_path(cache_file, name.str().c_str());
+    return true;
+}
+
+bool deps_cache::read(const pal::string_t& cache_file, bool portable, deps_document_t* document)
+{
+    pal::ifstream_t file(cache_file, std::ios::binary);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    std::string bytes;
+    bytes.assign(pal::istreambuf_iterator_t(file), pal::istreambuf_iterator_t());
+
+    binary_reader_t reader(bytes.data(), bytes.data() + bytes.size());
+    if (!read_document(&reader, portable, document))
+    {
+        trace::verbose(_X("Ignoring the deps cache [%s] as it could not be read"), cache_file.c_str());
+        *document = deps_document_t();
+        return false;
+    }
+    return true;
+}
+
+bool deps_cache::write(const pal::string_t& cache_file, bool portable, const deps_document_t& document)
+{
+    std::string bytes;
+    binary_writer_t writer(&bytes);
+
+    writer.write_u32(s_cache_magic);
+    writer.write_u32(s_cache_version);
+    writer.write_u32(sizeof(pal::char_t));
+    writer.write_u32(portable ? 1 : 0);
+
+    writer.write_u64(document.hash);
+    writer.write_string(document.target_name);
+
+    writer.write_u32((uint32_t) document.targets.size());
+    for (const auto& entry : document.targets)
+    {
+        writer.write_string(entry.name);
+        writer.write_u64(entry.hash);
+        for (const auto& assets : entry.assets)
+        {
+            writer.write_strings(assets);
+        }
+        writer.write_u32((uint32_t) entry.rid_assets.size());
+        for (const auto& rid_asset : entry.rid_assets)
+        {
+            writer.write_string(rid_asset.rid);
+            writer.write_u32((uint32_t) rid_asset.asset_type);
+            writer.write_string(rid_asset.rel_path);
+        }
+    }
+
+    writer.write_u32(document.has_libraries ? 1 : 0);
+    writer.write_u32((uint32_t) document.libraries.size());
+    for (const auto& entry : document.libraries)
+    {
+        writer.write_string(entry.name);
+        writer.write_u64(entry.hash);
+        writer.write_string(entry.type);
+        writer.write_string(entry.sha512);
+        writer.write_u32(entry.serviceable ? 1 : 0);
+        writer.write_bytes(entry.error);
+    }
+
+    writer.write_u64(document.runtimes_hash);
+    writer.write_u32((uint32_t) document.runtimes.size());
+    for (const auto& rid : document.runtimes)
+    {
+        writer.write_string(rid.first);
+        writer.write_strings(rid.second);
+    }
+
+    if (!write_file_atomically(cache_file, bytes))
+    {
+        trace::verbose(_X("Could not write the deps cache [%s]"), cache_file.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __DEPS_CACHE_H_
+#define __DEPS_CACHE_H_
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "pal.h"
+#include "deps_entry.h"
+
+// A "runtimeTargets" asset of a library in the runtime target.
+struct deps_rid_asset_t
+{
+    pal::string_t rid;
+    int asset_type;
+    pal::string_t rel_path;
+};
+
+// The entry of a library in "targets" for the runtime target.
+struct deps_target_entry_t
+{
+    pal::string_t name;
+    uint64_t hash;
+    std::array<std::vector<pal::string_t>, deps_entry_t::asset_types::count> assets;
+    std::vector<deps_rid_asset_t> rid_assets;
+};
+
+// The entry of a library in "libraries".
+struct deps_library_entry_t
+{
+    pal::string_t name;
+    uint64_t hash;
+    pal::string_t type;
+    pal::string_t sha512;
+    bool serviceable;
+
+    // Why "sha512" or "serviceable" could not be read. It is only an error if
+    // the library is a package with assets in the runtime target.
+    std::string error;
+};
+
+// The sections of a deps file the host reads, parsed per library. Each entry
+// keeps the hash of its JSON text, so that a cached document can be brought up
+// to date by parsing only the entries that changed.
+struct deps_document_t
+{
+    uint64_t hash;
+    pal::string_t target_name;
+    std::vector<deps_target_entry_t> targets;    // In document order.
+    bool has_libraries;
+    std::vector<deps_library_entry_t> libraries; // Sorted by name.
+    uint64_t runtimes_hash;
+    std::vector<std::pair<pal::string_t, std::vector<pal::string_t>>> runtimes;
+
+    deps_document_t()
+        : hash(0)
+        , has_libraries(false)
+        , runtimes_hash(0)
+    {
+    }
+};
+
+// Binary cache of deps documents in the host cache directory, one file per deps file.
+namespace deps_cache
+{
+    uint64_t hash(const char* data, size_t size);
+
+    bool get_cache_file(const pal::string_t& deps_path, pal::string_t* cache_file);
+    bool read(const pal::string_t& cache_file, bool portable, deps_document_t* document);
+    bool write(const pal::string_t& cache_file, bool portable, const deps_document_t& document);
+};
+
+#endif // __DEPS_CACHE_H_
@@ -4,10 +4,11 @@
 #include "pal.h"
 #include "utils.h"
 #include "deps_entry.h"
+#include "dir_cache.h"
 #include "trace.h"
 
 
-bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str) const
+bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str, dir_cache_t* dir_cache) const
 {
     pal::string_t& candidate = *str;
 
@@ -35,7 +36,7 @@ bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::st
     pal::string_t sub_path = look_in_base ? get_filename(pal_relative_path) : pal_relative_path;
     append_path(&candidate, sub_path.c_str());
 
-    bool exists = pal::file_exists(candidate);
+    bool exists = (dir_cache != nullptr) ? dir_cache->file_exists(candidate) : pal::file_exists(candidate);
     const pal::char_t* query_type = look_in_base ? _X("Local") : _X("Relative");
     if (!exists)
     {
@@ -60,9 +61,9 @@ bool deps_entry_t::to_path(const pal::string_t& base, bool look_in_base, pal::st
 // Returns:
 //    If the file exists in the path relative to the "base" directory.
 //
-bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str, dir_cache_t* dir_cache) const
 {
-    return to_path(base, true, str);
+    return to_path(base, true, str, dir_cache);
 }
 // -----------------------------------------------------------------------------
 // Given a "base" directory, yield the relative path of this file in the package
@@ -76,9 +77,9 @@ bool deps_entry_t::to_dir_path(const pal::string_t& base, pal::string_t* str) co
 // Returns:
 //    If the file exists in the path relative to the "base" directory.
 //
-bool deps_entry_t::to_rel_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_rel_path(const pal::string_t& base, pal::string_t* str, dir_cache_t* dir_cache) const
 {
-    return to_path(base, false, str);
+    return to_path(base, false, str, dir_cache);
 }
 
 // -----------------------------------------------------------------------------
@@ -93,7 +94,7 @@ bool deps_entry_t::to_rel_path(const pal::string_t& base, pal::string_t* str) co
 // Returns:
 //    If the file exists in the path relative to the "base" directory.
 //
-bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str, dir_cache_t* dir_cache) const
 {
     str->clear();
 
@@ -107,7 +108,7 @@ bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str) c
     append_path(&new_base, library_name.c_str());
     append_path(&new_base, library_version.c_str());
 
-    return to_rel_path(new_base, str);
+    return to_rel_path(new_base, str, dir_cache);
 }
 
 // -----------------------------------------------------------------------------
@@ -131,7 +132,7 @@ bool deps_entry_t::to_full_path(const pal::string_t& base, pal::string_t* str) c
 //
 // See: to_full_path(base, str)
 //
-bool deps_entry_t::to_hash_matched_path(const pal::string_t& base, pal::string_t* str) const
+bool deps_entry_t::to_hash_matched_path(const pal::string_t& base, pal::string_t* str, dir_cache_t* dir_cache) const
 {
     pal::string_t& candidate = *str;
 
@@ -196,5 +197,5 @@ bool deps_entry_t::to_hash_matched_path(const pal::string_t& base, pal::string_t
     }
 
     // All good, just append the relative dir to base.
-    return to_full_path(base, &candidate);
+    return to_full_path(base, &candidate, dir_cache);
 }
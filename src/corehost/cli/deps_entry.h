@@ -9,6 +9,8 @@
 #include <vector>
 #include "pal.h"
 
+class dir_cache_t;
+
 struct deps_entry_t
 {
     enum asset_types
@@ -32,21 +34,23 @@ struct deps_entry_t
     bool is_rid_specific;
 
 
+    // The methods below check that the file exists using "dir_cache" if one is given.
+
     // Given a "base" dir, yield the filepath within this directory or relative to this directory based on "look_in_base"
-    bool to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str) const;
+    bool to_path(const pal::string_t& base, bool look_in_base, pal::string_t* str, dir_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the file path within this directory.
-    bool to_dir_path(const pal::string_t& base, pal::string_t* str) const;
+    bool to_dir_path(const pal::string_t& base, pal::string_t* str, dir_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the relative path in the package layout.
-    bool to_rel_path(const pal::string_t& base, pal::string_t* str) const;
+    bool to_rel_path(const pal::string_t& base, pal::string_t* str, dir_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the relative path with package name, version in the package layout.
-    bool to_full_path(const pal::string_t& root, pal::string_t* str) const;
+    bool to_full_path(const pal::string_t& root, pal::string_t* str, dir_cache_t* dir_cache = nullptr) const;
 
     // Given a "base" dir, yield the relative path with package name, version in the package layout only if
     // the hash matches contents of the hash file.
-    bool to_hash_matched_path(const pal::string_t& root, pal::string_t* str) const;
+    bool to_hash_matched_path(const pal::string_t& root, pal::string_t* str, dir_cache_t* dir_cache = nullptr) const;
 };
 
 #endif // __DEPS_ENTRY_H_
@@ -3,13 +3,18 @@
 
 #include "deps_entry.h"
 #include "deps_format.h"
+#include "json_scanner.h"
+#include "deps_cache.h"
 #include "utils.h"
+#include "cpprest/json.h"
 #include "trace.h"
 #include <tuple>
 #include <array>
 #include <iterator>
 #include <cassert>
 #include <functional>
+#include <algorithm>
+#include <stdexcept>
 
 const std::array<const pal::char_t*, deps_entry_t::asset_types::count> deps_entry_t::s_known_asset_types = {
     _X("runtime"), _X("resources"), _X("native")
@@ -26,35 +31,42 @@ const deps_entry_t& deps_json_t::try_ni(const deps_entry_t& entry) const
 }
 
 void deps_json_t::reconcile_libraries_with_targets(
-    const json_value& json,
+    const deps_document_t& document,
     const std::function<bool(const pal::string_t&)>& library_exists_fn,
     const std::function<const std::vector<pal::string_t>&(const pal::string_t&, int, bool*)>& get_rel_paths_by_asset_type_fn)
 {
-    const auto& libraries = json.at(_X("libraries")).as_object();
-    for (const auto& library : libraries)
+    if (!document.has_libraries)
     {
-        trace::info(_X("Reconciling library %s"), library.first.c_str());
+        throw web::json::json_exception(_X("Key not found"));
+    }
+
+    for (const auto& library : document.libraries)
+    {
+        trace::info(_X("Reconciling library %s"), library.name.c_str());
 
-        if (pal::to_lower(library.second.at(_X("type")).as_string()) != _X("package"))
+        if (pal::to_lower(library.type) != _X("package"))
         {
-            trace::info(_X("Library %s is not a package"), library.first.c_str());
+            trace::info(_X("Library %s is not a package"), library.name.c_str());
             continue;
         }
-        if (!library_exists_fn(library.first))
+        if (!library_exists_fn(library.name))
         {
-            trace::info(_X("Library %s does not exist"), library.first.c_str());
+            trace::info(_X("Library %s does not exist"), library.name.c_str());
             continue;
         }
 
-        const auto& properties = library.second.as_object();
+        if (!library.error.empty())
+        {
+            throw std::runtime_error(library.error);
+        }
 
-        const pal::string_t& hash = properties.at(_X("sha512")).as_string();
-        bool serviceable = properties.at(_X("serviceable")).as_bool();
+        const pal::string_t& hash = library.sha512;
+        bool serviceable = library.serviceable;
 
         for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
         {
             bool rid_specific = false;
-            for (const auto& rel_path : get_rel_paths_by_asset_type_fn(library.first, i, &rid_specific))
+            for (const auto& rel_path : get_rel_paths_by_asset_type_fn(library.name, i, &rid_specific))
             {
                 bool ni_dll = false;
                 auto asset_name = get_filename_without_ext(rel_path);
@@ -65,9 +77,9 @@ void deps_json_t::reconcile_libraries_with_targets(
                 }
 
                 deps_entry_t entry;
-                size_t pos = library.first.find(_X("/"));
-                entry.library_name = library.first.substr(0, pos);
-                entry.library_version = library.first.substr(pos + 1);
+                size_t pos = library.name.find(_X("/"));
+                entry.library_name = library.name.substr(0, pos);
+                entry.library_version = library.name.substr(pos + 1);
                 entry.library_type = _X("package");
                 entry.library_hash = hash;
                 entry.asset_name = asset_name;
@@ -124,31 +136,50 @@ pal::string_t get_own_rid()
 #endif
 }
 
-bool deps_json_t::perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph)
+rid_ranks_t::rid_ranks_t(const pal::string_t& host_rid, const rid_fallback_graph_t& rid_fallback_graph)
+    : m_host_rid(host_rid)
+    , m_has_fallbacks(false)
+{
+    m_ranks.emplace(host_rid, 0);
+
+    auto iter = rid_fallback_graph.find(host_rid);
+    if (iter == rid_fallback_graph.end())
+    {
+        return;
+    }
+
+    m_has_fallbacks = true;
+
+    // The first occurrence of a RID in the fallback chain determines its rank.
+    const auto& fallback_rids = iter->second;
+    for (size_t i = 0; i < fallback_rids.size(); ++i)
+    {
+        m_ranks.emplace(fallback_rids[i], (int) i + 1);
+    }
+}
+
+bool deps_json_t::perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_ranks_t& rid_ranks)
 {
-    pal::string_t host_rid = get_own_rid();
     for (auto& package : portable_assets->libs)
     {
-        pal::string_t matched_rid = package.second.rid_assets.count(host_rid) ? host_rid : _X("");
-        if (matched_rid.empty())
+        // Pick the best ranked RID among the RIDs this package ships.
+        int matched_rank = -1;
+        pal::string_t matched_rid;
+        for (const auto& rid_asset : package.second.rid_assets)
         {
-            if (rid_fallback_graph.count(host_rid) == 0)
-            {
-                trace::warning(_X("The targeted framework does not support the runtime '%s'. Some native libraries from [%s] may fail to load on this platform."), host_rid.c_str(), package.first.c_str());
-            }
-            else
+            int rank = rid_ranks.rank(rid_asset.first);
+            if (rank >= 0 && (matched_rank < 0 || rank < matched_rank))
             {
-                const auto& fallback_rids = rid_fallback_graph.find(host_rid)->second;
-                auto iter = std::find_if(fallback_rids.begin(), fallback_rids.end(), [&package](const pal::string_t& rid) {
-                    return package.second.rid_assets.count(rid);
-                });
-                if (iter != fallback_rids.end())
-                {
-                    matched_rid = *iter;
-                }
+                matched_rank = rank;
+                matched_rid = rid_asset.first;
             }
         }
 
+        if (matched_rank != 0 && !rid_ranks.has_fallbacks())
+        {
+            trace::warning(_X("The targeted framework does not support the runtime '%s'. Some native libraries from [%s] may fail to load on this platform."), rid_ranks.host_rid().c_str(), package.first.c_str());
+        }
+
         if (matched_rid.empty())
         {
             package.second.rid_assets.clear();
@@ -171,72 +202,51 @@ bool deps_json_t::perform_rid_fallback(rid_specific_assets_t* portable_assets, c
 }
 
 
-bool deps_json_t::process_runtime_targets(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, rid_specific_assets_t* p_assets)
+bool deps_json_t::process_runtime_targets(const deps_document_t& document, rid_specific_assets_t* p_assets)
 {
     rid_specific_assets_t& assets = *p_assets;
-    for (const auto& package : json.at(_X("targets")).at(target_name).as_object())
+    for (const auto& package : document.targets)
     {
-        const auto& targets = package.second.as_object();
-        auto iter = targets.find(_X("runtimeTargets"));
-        if (iter == targets.end())
+        for (const auto& rid_asset : package.rid_assets)
         {
-            continue;
-        }
-
-        const auto& files = iter->second.as_object();
-        for (const auto& file : files)
-        {
-            const auto& type = file.second.at(_X("assetType")).as_string();
-            for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
-            {
-                if (pal::strcasecmp(type.c_str(), deps_entry_t::s_known_asset_types[i]) == 0)
-                {
-                    const auto& rid = file.second.at(_X("rid")).as_string();
-                    assets.libs[package.first].rid_assets[rid].by_type[i].vec.push_back(file.first);
-                }
-            }
+            assets.libs[package.name].rid_assets[rid_asset.rid].by_type[rid_asset.asset_type].vec.push_back(rid_asset.rel_path);
         }
     }
 
-    if (!perform_rid_fallback(&assets, rid_fallback_graph))
-    {
-        return false;
-    }
-
     return true;
 }
 
-bool deps_json_t::process_targets(const json_value& json, const pal::string_t& target_name, deps_assets_t* p_assets)
+bool deps_json_t::process_targets(const deps_document_t& document, deps_assets_t* p_assets)
 {
     deps_assets_t& assets = *p_assets;
-    for (const auto& package : json.at(_X("targets")).at(target_name).as_object())
+    for (const auto& package : document.targets)
     {
-        // if (package.second.at(_X("type")).as_string() != _X("package")) continue;
-        const auto& asset_types = package.second.as_object();
         for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
         {
-            auto iter = asset_types.find(deps_entry_t::s_known_asset_types[i]);
-            if (iter != asset_types.end())
+            for (const auto& rel_path : package.assets[i])
             {
-                for (const auto& file : iter->second.as_object())
-                {
-                    trace::info(_X("Adding %s asset %s from %s"), deps_entry_t::s_known_asset_types[i], file.first.c_str(), package.first.c_str());
-                    assets.libs[package.first].by_type[i].vec.push_back(file.first);
-                }
+                trace::info(_X("Adding %s asset %s from %s"), deps_entry_t::s_known_asset_types[i], rel_path.c_str(), package.name.c_str());
+                assets.libs[package.name].by_type[i].vec.push_back(rel_path);
             }
         }
     }
     return true;
 }
 
-bool deps_json_t::load_portable(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph)
+bool deps_json_t::load_portable(const deps_document_t& document)
 {
-    if (!process_runtime_targets(json, target_name, rid_fallback_graph, &m_rid_assets))
+    if (!process_runtime_targets(document, &m_rid_assets))
     {
         return false;
     }
 
-    if (!process_targets(json, target_name, &m_assets))
+    return process_targets(document, &m_assets);
+}
+
+bool deps_json_t::resolve_portable(const deps_document_t& document, const rid_fallback_graph_t& rid_fallback_graph)
+{
+    rid_ranks_t rid_ranks(get_own_rid(), rid_fallback_graph);
+    if (!perform_rid_fallback(&m_rid_assets, rid_ranks))
     {
         return false;
     }
@@ -271,18 +281,43 @@ bool deps_json_t::load_portable(const json_value& json, const pal::string_t& tar
         return empty;
     };
 
-    reconcile_libraries_with_targets(json, package_exists, get_relpaths);
+    reconcile_libraries_with_targets(document, package_exists, get_relpaths);
 
     return true;
 }
 
-bool deps_json_t::load_standalone(const json_value& json, const pal::string_t& target_name)
+bool deps_json_t::load_standalone(const deps_document_t& document)
 {
-    if (!process_targets(json, target_name, &m_assets))
+    if (!process_targets(document, &m_assets))
     {
         return false;
     }
 
+    for (const auto& rid : document.runtimes)
+    {
+        auto& vec = m_rid_fallback_graph[rid.first];
+        vec.insert(vec.end(), rid.second.begin(), rid.second.end());
+    }
+
+    if (trace::is_enabled())
+    {
+        trace::verbose(_X("The rid fallback graph is: {"));
+        for (const auto& rid : m_rid_fallback_graph)
+        {
+            trace::verbose(_X("%s => ["), rid.first.c_str());
+            for (const auto& fallback : rid.second)
+            {
+                trace::verbose(_X("%s, "), fallback.c_str());
+            }
+            trace::verbose(_X("]"));
+        }
+        trace::verbose(_X("}"));
+    }
+    return true;
+}
+
+bool deps_json_t::resolve_standalone(const deps_document_t& document)
+{
     auto package_exists = [&](const pal::string_t& package) -> bool {
         return m_assets.libs.count(package);
     };
@@ -292,96 +327,445 @@ bool deps_json_t::load_standalone(const json_value& json, const pal::string_t& t
         return m_assets.libs[package].by_type[type_index].vec;
     };
 
-    reconcile_libraries_with_targets(json, package_exists, get_relpaths);
+    reconcile_libraries_with_targets(document, package_exists, get_relpaths);
+    return true;
+}
 
-    const auto& json_object = json.as_object();
-    const auto iter = json_object.find(_X("runtimes"));
-    if (iter != json_object.end())
+// -----------------------------------------------------------------------------
+// Index the packages that have assets for the target, so has_package() does
+// not need to build a "name/version" key per query.
+//
+void deps_json_t::build_package_index()
+{
+    std::vector<const pal::string_t*> keys;
+    for (const auto& package : m_rid_assets.libs)
     {
-        for (const auto& rid : iter->second.as_object())
+        if (!package.second.rid_assets.empty())
         {
-            auto& vec = m_rid_fallback_graph[rid.first];
-            for (const auto& fallback : rid.second.as_array())
+            keys.push_back(&package.first);
+        }
+    }
+    for (const auto& package : m_assets.libs)
+    {
+        keys.push_back(&package.first);
+    }
+
+    // Split all the keys first; the index points into m_packages, which must not grow afterwards.
+    m_packages.clear();
+    m_packages.reserve(keys.size());
+    for (const auto& key : keys)
+    {
+        size_t pos = key->find(_X('/'));
+        if (pos != pal::string_t::npos)
+        {
+            m_packages.emplace_back(key->substr(0, pos), key->substr(pos + 1));
+        }
+    }
+
+    m_package_index.clear();
+    m_package_index.reserve(m_packages.size());
+    for (const auto& package : m_packages)
+    {
+        package_key_t index_key = { &package.first, &package.second };
+        m_package_index.insert(index_key);
+    }
+}
+
+bool deps_json_t::has_package(const pal::string_t& name, const pal::string_t& ver) const
+{
+    package_key_t key = { &name, &ver };
+    return m_package_index.count(key) != 0;
+}
+
+namespace
+{
+web::json::value parse_range(const json_scanner::range_t& range)
+{
+    json_scanner::range_streambuf_t buf(range);
+    std::istream stream(&buf);
+    return web::json::value::parse(stream);
+}
+
+// Read the assets of a library in the runtime target. "runtimeTargets" are
+// only used by portable apps.
+void read_target_entry(const web::json::value& json, bool portable, deps_target_entry_t* entry)
+{
+    const auto& asset_types = json.as_object();
+    for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
+    {
+        auto iter = asset_types.find(deps_entry_t::s_known_asset_types[i]);
+        if (iter != asset_types.end())
+        {
+            for (const auto& file : iter->second.as_object())
             {
-                vec.push_back(fallback.as_string());
+                entry->assets[i].push_back(file.first);
             }
         }
     }
 
-    if (trace::is_enabled())
+    if (!portable)
     {
-        trace::verbose(_X("The rid fallback graph is: {"));
-        for (const auto& rid : m_rid_fallback_graph)
+        return;
+    }
+
+    auto iter = asset_types.find(_X("runtimeTargets"));
+    if (iter == asset_types.end())
+    {
+        return;
+    }
+
+    for (const auto& file : iter->second.as_object())
+    {
+        const auto& type = file.second.at(_X("assetType")).as_string();
+        for (int i = 0; i < deps_entry_t::s_known_asset_types.size(); ++i)
         {
-            trace::verbose(_X("%s => ["), rid.first.c_str());
-            for (const auto& fallback : rid.second)
+            if (pal::strcasecmp(type.c_str(), deps_entry_t::s_known_asset_types[i]) == 0)
             {
-                trace::verbose(_X("%s, "), fallback.c_str());
+                deps_rid_asset_t rid_asset = { file.second.at(_X("rid")).as_string(), i, file.first };
+                entry->rid_assets.push_back(rid_asset);
             }
-            trace::verbose(_X("]"));
         }
-        trace::verbose(_X("}"));
     }
-    return true;
 }
 
-bool deps_json_t::has_package(const pal::string_t& name, const pal::string_t& ver) const
+// Read the properties of a library. A missing "sha512" or "serviceable" is
+// recorded rather than thrown; it only matters for packages in the target.
+void read_library_entry(const web::json::value& json, deps_library_entry_t* entry)
+{
+    entry->type = json.at(_X("type")).as_string();
+    entry->serviceable = false;
+    try
+    {
+        entry->sha512 = json.at(_X("sha512")).as_string();
+        entry->serviceable = json.at(_X("serviceable")).as_bool();
+    }
+    catch (const std::exception& e)
+    {
+        entry->error = e.what();
+    }
+}
+
+void read_runtimes(const web::json::value& json, std::vector<std::pair<pal::string_t, std::vector<pal::string_t>>>* runtimes)
 {
-    pal::string_t pv = name;
-    pv.push_back(_X('/'));
-    pv.append(ver);
-    
-    auto iter = m_rid_assets.libs.find(pv);
-    if (iter != m_rid_assets.libs.end())
+    for (const auto& rid : json.as_object())
     {
-        if (!iter->second.rid_assets.empty())
+        std::vector<pal::string_t> fallbacks;
+        for (const auto& fallback : rid.second.as_array())
         {
-            return true;
+            fallbacks.push_back(fallback.as_string());
         }
+        runtimes->emplace_back(rid.first, std::move(fallbacks));
     }
-    
-    return m_assets.libs.count(pv);
 }
 
+// Map the names of cached entries to the entries.
+template <typename T>
+std::unordered_map<pal::string_t, const T*> index_entries(const std::vector<T>& entries)
+{
+    std::unordered_map<pal::string_t, const T*> index;
+    index.reserve(entries.size());
+    for (const auto& entry : entries)
+    {
+        index.emplace(entry.name, &entry);
+    }
+    return index;
+}
+} // end of anonymous namespace
+
 // -----------------------------------------------------------------------------
-// Load the deps file and parse its "entry" lines which contain the "fields" of
-// the entry. Populate an array of these entries.
+// Parse the sections of the deps file the host reads into "p_document".
+//
+// Description:
+//    The top level members are located at byte level first, so "runtimeTarget"
+//    is found even if it comes after "targets". Sibling targets and any other
+//    sections are skipped without being parsed. The entries of the selected
+//    target and of "libraries" are parsed one at a time; if "cached" is given,
+//    an entry whose JSON text hashes the same as the cached entry of the same
+//    name is taken from the cache instead.
+//
+// Returns:
+//    The number of entries that were parsed in "p_parsed".
 //
-bool deps_json_t::load(bool portable, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph)
+bool deps_json_t::parse_document(const json_scanner::range_t& document, const pal::string_t& deps_path, const deps_document_t* cached, deps_document_t* p_document, size_t* p_parsed)
 {
-    // If file doesn't exist, then assume parsed.
-    if (!pal::file_exists(deps_path))
+    using json_scanner::range_t;
+
+    range_t runtime_target_range, targets_range, libraries_range, runtimes_range;
+    bool scanned = json_scanner::for_each_member(document, [&](const std::string& key, const range_t& value) -> bool {
+        range_t* range = nullptr;
+        if (key == "runtimeTarget")
+        {
+            range = &runtime_target_range;
+        }
+        else if (key == "targets")
+        {
+            range = &targets_range;
+        }
+        else if (key == "libraries")
+        {
+            range = &libraries_range;
+        }
+        else if (key == "runtimes")
+        {
+            range = &runtimes_range;
+        }
+        if (range != nullptr && range->empty())
+        {
+            *range = value;
+        }
+        return true;
+    });
+    if (!scanned)
     {
-        trace::verbose(_X("Could not locate the dependencies manifest file [%s]. Some libraries may fail to resolve."), deps_path.c_str());
+        trace::error(_X("The dependencies manifest file [%s] is not a well formed JSON object"), deps_path.c_str());
+        return false;
+    }
+
+    if (runtime_target_range.empty() || targets_range.empty())
+    {
+        throw web::json::json_exception(_X("Key not found"));
+    }
+
+    deps_document_t& doc = *p_document;
+    size_t& parsed = *p_parsed;
+    parsed = 0;
+
+    const auto runtime_target = parse_range(runtime_target_range);
+    doc.target_name = runtime_target.is_string()?
+        runtime_target.as_string():
+        runtime_target.at(_X("name")).as_string();
+
+    range_t target_range;
+    scanned = json_scanner::for_each_member(targets_range, [&](const std::string& key, const range_t& value) -> bool {
+        pal::string_t pal_key;
+        if (pal::utf8_palstring(key, &pal_key) && pal_key == doc.target_name)
+        {
+            target_range = value;
+            return false;
+        }
         return true;
+    });
+    if (!scanned)
+    {
+        trace::error(_X("The targets section of the dependencies manifest file [%s] is not a well formed JSON object"), deps_path.c_str());
+        return false;
+    }
+    if (target_range.empty())
+    {
+        throw web::json::json_exception(_X("Key not found"));
     }
 
-    // Somehow the file stream could not be opened. This is an error.
-    pal::ifstream_t file(deps_path);
-    if (!file.good())
+    // Cached entries only apply to the same runtime target.
+    std::unordered_map<pal::string_t, const deps_target_entry_t*> cached_targets;
+    std::unordered_map<pal::string_t, const deps_library_entry_t*> cached_libraries;
+    if (cached != nullptr && cached->target_name == doc.target_name)
     {
-        trace::error(_X("Could not open dependencies manifest file [%s]"), deps_path.c_str());
+        cached_targets = index_entries(cached->targets);
+        cached_libraries = index_entries(cached->libraries);
+    }
+
+    scanned = json_scanner::for_each_member(target_range, [&](const std::string& key, const range_t& value) -> bool {
+        doc.targets.emplace_back();
+        deps_target_entry_t& entry = doc.targets.back();
+        entry.name.clear();
+        (void) pal::utf8_palstring(key, &entry.name);
+        entry.hash = (cached != nullptr) ? deps_cache::hash(value.begin, value.size()) : 0;
+
+        auto iter = cached_targets.find(entry.name);
+        if (iter != cached_targets.end() && iter->second->hash == entry.hash)
+        {
+            entry = *iter->second;
+        }
+        else
+        {
+            read_target_entry(parse_range(value), m_portable, &entry);
+            ++parsed;
+        }
+        return true;
+    });
+    if (!scanned)
+    {
+        trace::error(_X("The target [%s] in the dependencies manifest file [%s] is not a well formed JSON object"), doc.target_name.c_str(), deps_path.c_str());
         return false;
     }
 
-    if (skip_utf8_bom(&file))
+    if (!libraries_range.empty())
+    {
+        doc.has_libraries = true;
+        scanned = json_scanner::for_each_member(libraries_range, [&](const std::string& key, const range_t& value) -> bool {
+            doc.libraries.emplace_back();
+            deps_library_entry_t& entry = doc.libraries.back();
+            (void) pal::utf8_palstring(key, &entry.name);
+            entry.hash = (cached != nullptr) ? deps_cache::hash(value.begin, value.size()) : 0;
+
+            auto iter = cached_libraries.find(entry.name);
+            if (iter != cached_libraries.end() && iter->second->hash == entry.hash)
+            {
+                entry = *iter->second;
+            }
+            else
+            {
+                read_library_entry(parse_range(value), &entry);
+                ++parsed;
+            }
+            return true;
+        });
+        if (!scanned)
+        {
+            trace::error(_X("The libraries section of the dependencies manifest file [%s] is not a well formed JSON object"), deps_path.c_str());
+            return false;
+        }
+
+        // Libraries are reconciled in the order of their names.
+        std::sort(doc.libraries.begin(), doc.libraries.end(),
+            [](const deps_library_entry_t& left, const deps_library_entry_t& right) { return left.name < right.name; });
+    }
+
+    // The fallback graph of portable apps comes from the framework.
+    if (!m_portable && !runtimes_range.empty())
+    {
+        doc.runtimes_hash = (cached != nullptr) ? deps_cache::hash(runtimes_range.begin, runtimes_range.size()) : 0;
+        if (cached != nullptr && cached->runtimes_hash == doc.runtimes_hash && cached->target_name == doc.target_name)
+        {
+            doc.runtimes = cached->runtimes;
+        }
+        else
+        {
+            read_runtimes(parse_range(runtimes_range), &doc.runtimes);
+            ++parsed;
+        }
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Load the deps file, or "deps_data" if the host already read it, and collect
+// the assets of the runtime target. The entries are only built by resolve(),
+// since the RID fallback of a portable app needs the framework's graph.
+//
+bool deps_json_t::parse(bool portable, const pal::string_t& deps_path, const json_scanner::range_t& deps_data)
+{
+    m_portable = portable;
+    m_deps_path = deps_path;
+    m_valid = load(portable, deps_path, deps_data);
+    return m_valid;
+}
+
+// -----------------------------------------------------------------------------
+// Perform the RID fallback of the parsed deps file and reconcile its libraries
+// with the target assets into entries. The graph is only used for portable apps.
+//
+bool deps_json_t::resolve(const rid_fallback_graph_t& rid_fallback_graph)
+{
+    // Nothing to resolve if the parse failed or there was no deps file.
+    if (!m_valid || !m_document)
     {
-        trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), deps_path.c_str());
+        return m_valid;
     }
 
     try
     {
-        const auto json = json_value::parse(file);
+        m_valid = (m_portable) ? resolve_portable(*m_document, rid_fallback_graph) : resolve_standalone(*m_document);
+        if (m_valid)
+        {
+            build_package_index();
+        }
+    }
+    catch (const std::exception& je)
+    {
+        pal::string_t jes;
+        (void) pal::utf8_palstring(je.what(), &jes);
+        trace::error(_X("A JSON parsing exception occurred in [%s]: %s"), m_deps_path.c_str(), jes.c_str());
+        m_valid = false;
+    }
 
-        const auto& runtime_target = json.at(_X("runtimeTarget"));
+    // The document is no longer needed once the entries are built.
+    m_document.reset();
+    return m_valid;
+}
 
-        const pal::string_t& name = runtime_target.is_string()?
-            runtime_target.as_string():
-            runtime_target.at(_X("name")).as_string();
+// -----------------------------------------------------------------------------
+// Load the deps file and parse its "entry" lines which contain the "fields" of
+// the entry. Populate an array of these entries.
+//
+// Description:
+//    If the host cache is enabled, the parsed document is kept in a per deps
+//    file cache. An unchanged file is taken from the cache as is; a changed one
+//    is reparsed only for the entries whose JSON text changed.
+//
+bool deps_json_t::load(bool portable, const pal::string_t& deps_path, const json_scanner::range_t& deps_data)
+{
+    std::string bytes;
+    json_scanner::range_t document = deps_data;
+    if (!document.empty())
+    {
+        trace::verbose(_X("Using the contents of [%s] passed by the host"), deps_path.c_str());
+    }
+    else
+    {
+        // If file doesn't exist, then assume parsed.
+        if (!pal::file_exists(deps_path))
+        {
+            trace::verbose(_X("Could not locate the dependencies manifest file [%s]. Some libraries may fail to resolve."), deps_path.c_str());
+            return true;
+        }
+
+        // Somehow the file stream could not be opened. This is an error.
+        pal::ifstream_t file(deps_path);
+        if (!file.good())
+        {
+            trace::error(_X("Could not open dependencies manifest file [%s]"), deps_path.c_str());
+            return false;
+        }
+
+        if (skip_utf8_bom(&file))
+        {
+            trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), deps_path.c_str());
+        }
+
+        bytes.assign(pal::istreambuf_iterator_t(file), pal::istreambuf_iterator_t());
+        document = json_scanner::range_t(bytes.data(), bytes.data() + bytes.size());
+    }
+
+    try
+    {
+        m_document = std::unique_ptr<deps_document_t>(new deps_document_t());
+
+        pal::string_t cache_file;
+        bool use_cache = deps_cache::get_cache_file(deps_path, &cache_file);
+        deps_document_t cached;
+        uint64_t hash = 0;
+        if (use_cache)
+        {
+            hash = deps_cache::hash(document.begin, document.size());
+            (void) deps_cache::read(cache_file, portable, &cached);
+        }
+
+        if (use_cache && cached.hash == hash && !cached.target_name.empty())
+        {
+            trace::verbose(_X("Using the deps cache [%s] for [%s]"), cache_file.c_str(), deps_path.c_str());
+            *m_document = std::move(cached);
+        }
+        else
+        {
+            size_t parsed = 0;
+            if (!parse_document(document, deps_path, use_cache ? &cached : nullptr, m_document.get(), &parsed))
+            {
+                return false;
+            }
+
+            if (use_cache)
+            {
+                trace::verbose(_X("Parsed %d changed entries of [%s], updating the deps cache [%s]"), parsed, deps_path.c_str(), cache_file.c_str());
+                m_document->hash = hash;
+                (void) deps_cache::write(cache_file, portable, *m_document);
+            }
+        }
 
         trace::verbose(_X("Loading deps file... %s as portable=[%d]"), deps_path.c_str(), portable);
 
-        return (portable) ? load_portable(json, name, rid_fallback_graph) : load_standalone(json, name);
+        return (portable) ? load_portable(*m_document) : load_standalone(*m_document);
     }
     catch (const std::exception& je)
     {
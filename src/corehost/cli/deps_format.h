@@ -10,24 +10,88 @@
 #include <functional>
 #include "pal.h"
 #include "deps_entry.h"
-#include "cpprest/json.h"
+#include "json_scanner.h"
+#include "deps_cache.h"
+
+typedef std::unordered_map<pal::string_t, std::vector<pal::string_t>> str_to_vector_map_t;
+typedef str_to_vector_map_t rid_fallback_graph_t;
+
+pal::string_t get_own_rid();
+
+// Compiled form of the host RID and its fallback chain. Maps a RID to its rank in
+// the chain (0 for the host RID itself), so choosing the best RID for a package
+// only compares the ranks of the RIDs that package ships.
+class rid_ranks_t
+{
+public:
+    rid_ranks_t(const pal::string_t& host_rid, const rid_fallback_graph_t& rid_fallback_graph);
+
+    // Rank of the RID, lower is better; -1 if the RID does not apply to the host.
+    int rank(const pal::string_t& rid) const
+    {
+        auto iter = m_ranks.find(rid);
+        return (iter == m_ranks.end()) ? -1 : iter->second;
+    }
+
+    bool is_applicable(const pal::string_t& rid) const
+    {
+        return m_ranks.count(rid) != 0;
+    }
+
+    // Whether the fallback graph knows about the host RID at all.
+    bool has_fallbacks() const
+    {
+        return m_has_fallbacks;
+    }
+
+    const pal::string_t& host_rid() const
+    {
+        return m_host_rid;
+    }
+
+private:
+    pal::string_t m_host_rid;
+    std::unordered_map<pal::string_t, int> m_ranks;
+    bool m_has_fallbacks;
+};
 
 class deps_json_t
 {
-    typedef web::json::value json_value;
     struct vec_t { std::vector<pal::string_t> vec; };
     struct assets_t { std::array<vec_t, deps_entry_t::asset_types::count> by_type; };
     struct deps_assets_t { std::unordered_map<pal::string_t, assets_t> libs; };
     struct rid_assets_t { std::unordered_map<pal::string_t, assets_t> rid_assets; };
     struct rid_specific_assets_t { std::unordered_map<pal::string_t, rid_assets_t> libs; };
 
-    typedef std::unordered_map<pal::string_t, std::vector<pal::string_t>> str_to_vector_map_t;
-    typedef str_to_vector_map_t rid_fallback_graph_t;
+    // Key into the package index. Points to the name and version strings, so a
+    // lookup can be keyed on the caller's strings without building "name/version".
+    struct package_key_t
+    {
+        const pal::string_t* name;
+        const pal::string_t* version;
+    };
+    struct package_key_hash_t
+    {
+        size_t operator()(const package_key_t& key) const
+        {
+            std::hash<pal::string_t> hasher;
+            return hasher(*key.name) * 31 + hasher(*key.version);
+        }
+    };
+    struct package_key_equal_t
+    {
+        bool operator()(const package_key_t& left, const package_key_t& right) const
+        {
+            return *left.name == *right.name && *left.version == *right.version;
+        }
+    };
+    typedef std::unordered_set<package_key_t, package_key_hash_t, package_key_equal_t> package_index_t;
 
 
 public:
     deps_json_t()
-        : m_valid(false)
+        : m_portable(false)
+        , m_valid(false)
         , m_coreclr_index(-1)
         , m_hostpolicy_index(-1)
     {
@@ -41,9 +105,16 @@ public:
     deps_json_t(bool portable, const pal::string_t& deps_path, const rid_fallback_graph_t& graph)
         : deps_json_t()
     {
-        m_valid = load(portable, deps_path, graph);
+        if (parse(portable, deps_path))
+        {
+            resolve(graph);
+        }
     }
 
+    // The package index points into this object's own strings.
+    deps_json_t(const deps_json_t&) = delete;
+    deps_json_t& operator=(const deps_json_t&) = delete;
+
     const std::vector<deps_entry_t>& get_entries(deps_entry_t::asset_types type)
     {
         assert(type < deps_entry_t::asset_types::count);
@@ -86,19 +157,30 @@ public:
 
 	const deps_entry_t& try_ni(const deps_entry_t& entry) const;
 
+    // Loading is split so the deps files of an app and its framework can be parsed
+    // concurrently: parse() reads the file and collects the assets, resolve() builds
+    // the entries once the framework's RID fallback graph is available.
+    bool parse(bool portable, const pal::string_t& deps_path, const json_scanner::range_t& deps_data = json_scanner::range_t());
+    bool resolve(const rid_fallback_graph_t& rid_fallback_graph);
+
 private:
-    bool load_standalone(const json_value& json, const pal::string_t& target_name);
-    bool load_portable(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph);
-    bool load(bool portable, const pal::string_t& deps_path, const rid_fallback_graph_t& rid_fallback_graph);
-    bool process_runtime_targets(const json_value& json, const pal::string_t& target_name, const rid_fallback_graph_t& rid_fallback_graph, rid_specific_assets_t* p_assets);
-    bool process_targets(const json_value& json, const pal::string_t& target_name, deps_assets_t* p_assets);
+    bool load_standalone(const deps_document_t& document);
+    bool load_portable(const deps_document_t& document);
+    bool load(bool portable, const pal::string_t& deps_path, const json_scanner::range_t& deps_data);
+    bool resolve_standalone(const deps_document_t& document);
+    bool resolve_portable(const deps_document_t& document, const rid_fallback_graph_t& rid_fallback_graph);
+    bool parse_document(const json_scanner::range_t& document, const pal::string_t& deps_path, const deps_document_t* cached, deps_document_t* p_document, size_t* p_parsed);
+    bool process_runtime_targets(const deps_document_t& document, rid_specific_assets_t* p_assets);
+    bool process_targets(const deps_document_t& document, deps_assets_t* p_assets);
 
     void reconcile_libraries_with_targets(
-        const json_value& json,
+        const deps_document_t& document,
         const std::function<bool(const pal::string_t&)>& library_exists_fn,
         const std::function<const std::vector<pal::string_t>&(const pal::string_t&, int, bool*)>& get_rel_paths_by_asset_type_fn);
 
-    bool perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_fallback_graph_t& rid_fallback_graph);
+    bool perform_rid_fallback(rid_specific_assets_t* portable_assets, const rid_ranks_t& rid_ranks);
+
+    void build_package_index();
 
     std::vector<deps_entry_t> m_deps_entries[deps_entry_t::asset_types::count];
 
@@ -106,7 +188,19 @@ private:
     rid_specific_assets_t m_rid_assets;
 
 	std::unordered_map<pal::string_t, int> m_ni_entries;
+
+    // Name and version of the packages that have assets for this target, and the
+    // index over them used by has_package().
+    std::vector<std::pair<pal::string_t, pal::string_t>> m_packages;
+    package_index_t m_package_index;
+
     rid_fallback_graph_t m_rid_fallback_graph;
+
+    // State kept between parse() and resolve().
+    pal::string_t m_deps_path;
+    std::unique_ptr<deps_document_t> m_document;
+    bool m_portable;
+
     int m_coreclr_index;
     int m_hostpolicy_index;
     bool m_valid;
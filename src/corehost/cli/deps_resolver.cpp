@@ -4,6 +4,10 @@
 #include <set>
 #include <functional>
 #include <cassert>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <system_error>
 
 #include "trace.h"
 #include "deps_entry.h"
@@ -12,20 +16,70 @@
 #include "utils.h"
 #include "fx_ver.h"
 #include "libhost.h"
+#include "path_list.h"
 
 namespace
 {
+// -----------------------------------------------------------------------------
+// The contents of "deps_file" if the host already read it, otherwise an empty
+// range to have the file read from disk.
+//
+json_scanner::range_t get_deps_data(const hostpolicy_init_t& init, const pal::string_t& deps_file)
+{
+    if (init.deps_data == nullptr || init.deps_data_file != deps_file)
+    {
+        return json_scanner::range_t();
+    }
+    return json_scanner::range_t(init.deps_data, init.deps_data + init.deps_data_size);
+}
+
+// -----------------------------------------------------------------------------
+// Dense ids for the asset names of one TPA resolution. Each name is hashed once
+// when it is interned; deduplication and app-local lookups then index arrays
+// with the id instead of hashing the name again.
+//
+class asset_name_table_t
+{
+public:
+    explicit asset_name_table_t(size_t capacity)
+    {
+        m_ids.reserve(capacity);
+    }
+
+    uint32_t intern(const pal::string_t& name)
+    {
+        auto iter = m_ids.find(name);
+        if (iter != m_ids.end())
+        {
+            return iter->second;
+        }
+        uint32_t id = (uint32_t) m_ids.size();
+        m_ids.emplace(name, id);
+        return id;
+    }
+
+    size_t size() const
+    {
+        return m_ids.size();
+    }
+
+private:
+    std::unordered_map<pal::string_t, uint32_t> m_ids;
+};
+
 // -----------------------------------------------------------------------------
 // A uniqifying append helper that doesn't let two entries with the same
-// "asset_name" be part of the "output" paths.
+// asset name id be part of the "output" paths. The resolved path is kept in
+// "real_paths" by asset name id.
 //
 void add_tpa_asset(
-    const pal::string_t& asset_name,
+    uint32_t asset_id,
     const pal::string_t& asset_path,
-    std::unordered_set<pal::string_t>* items,
-    pal::string_t* output)
+    std::vector<bool>* items,
+    std::vector<pal::string_t>* real_paths,
+    path_list_builder_t* output)
 {
-    if (items->count(asset_name))
+    if ((*items)[asset_id])
     {
         return;
     }
@@ -33,58 +87,92 @@ void add_tpa_asset(
     trace::verbose(_X("Adding tpa entry: %s"), asset_path.c_str());
 
     // Workaround for CoreFX not being able to resolve sym links.
-    pal::string_t real_asset_path = asset_path;
+    pal::string_t& real_asset_path = (*real_paths)[asset_id];
+    real_asset_path = asset_path;
     pal::realpath(&real_asset_path);
-    output->append(real_asset_path);
+    output->add(&real_asset_path);
 
-    output->push_back(PATH_SEPARATOR);
-    items->insert(asset_name);
+    (*items)[asset_id] = true;
 }
 
+// The directories added to a search path list: as they were given, so that a
+// directory given again is not resolved again, and resolved, so that two
+// directories are not added for the same real directory.
+struct unique_paths_t
+{
+    std::unordered_set<pal::string_t> given;
+    std::unordered_set<pal::string_t> real;
+};
+
 // -----------------------------------------------------------------------------
 // A uniqifying append helper that doesn't let two "paths" to be identical in
-// the "output" string.
+// the output lists.
 //
 void add_unique_path(
     deps_entry_t::asset_types asset_type,
     const pal::string_t& path,
-    std::unordered_set<pal::string_t>* existing,
-    pal::string_t* serviced,
-    pal::string_t* non_serviced,
+    unique_paths_t* existing,
+    path_list_builder_t* serviced,
+    path_list_builder_t* non_serviced,
     const pal::string_t& svc_dir)
 {
+    // The same directory comes up for many entries, such as the native
+    // directory of a package or the framework directory. It resolves the same
+    // way every time.
+    if (!existing->given.insert(path).second)
+    {
+        return;
+    }
+
     // Resolve sym links.
     pal::string_t real = path;
     pal::realpath(&real);
 
-    if (existing->count(real))
+    auto inserted = existing->real.insert(real);
+    if (!inserted.second)
     {
         return;
     }
 
     trace::verbose(_X("Adding to %s path: %s"), deps_entry_t::s_known_asset_types[asset_type], real.c_str());
 
+    // The set keeps the path for the list.
+    const pal::string_t* item = &*inserted.first;
     if (starts_with(real, svc_dir, false))
     {
-        serviced->append(real);
-        serviced->push_back(PATH_SEPARATOR);
+        serviced->add(item);
     }
     else
     {
-        non_serviced->append(real);
-        non_serviced->push_back(PATH_SEPARATOR);
+        non_serviced->add(item);
     }
-
-
-    existing->insert(real);
 }
 
+// A file of a directory that can be the assembly of a simple name: the name
+// is the first "name_length" characters of the file name, and the rank is
+// the priority of the extension that follows, lowest first.
+struct dir_assembly_t
+{
+    size_t file;
+    size_t name_length;
+    size_t rank;
+};
+
 } // end of anonymous namespace
 
 // -----------------------------------------------------------------------------
 // Load local assemblies by priority order of their file extensions and
 // unique-fied  by their simple name.
 //
+// Description:
+//    The listing is classified in one pass. A file can be a candidate for two
+//    simple names, "a.ni.dll" being both "a" by ".ni.dll" and "a.ni" by
+//    ".dll". The candidates are grouped by simple name without copying the
+//    names, and only the path and name of the best ranked candidate of each
+//    group, the first listed for its extension, are built. They are added in
+//    the order an extension by extension scan of the listing would add them,
+//    since the order of the map, and so of the TPA, follows it.
+//
 void deps_resolver_t::get_dir_assemblies(
     const pal::string_t& dir,
     const pal::string_t& dir_name,
@@ -93,43 +181,79 @@ void deps_resolver_t::get_dir_assemblies(
     trace::verbose(_X("Adding files from %s dir %s"), dir_name.c_str(), dir.c_str());
 
     // Managed extensions in priority order, pick DLL over EXE and NI over IL.
-    const pal::string_t managed_ext[] = { _X(".ni.dll"), _X(".dll"), _X(".ni.exe"), _X(".exe") };
+    const pal::char_t* managed_ext[] = { _X(".ni.dll"), _X(".dll"), _X(".ni.exe"), _X(".exe") };
+    const size_t managed_ext_count = sizeof(managed_ext) / sizeof(managed_ext[0]);
+    size_t managed_ext_length[managed_ext_count];
+    for (size_t rank = 0; rank < managed_ext_count; ++rank)
+    {
+        managed_ext_length[rank] = pal::string_t::traits_type::length(managed_ext[rank]);
+    }
 
     // List of files in the dir
     std::vector<pal::string_t> files;
     pal::readdir(dir, &files);
 
-    for (const auto& ext : managed_ext)
+    std::vector<dir_assembly_t> candidates;
+    candidates.reserve(files.size() * 2);
+    for (size_t i = 0; i < files.size(); ++i)
     {
-        for (const auto& file : files)
+        const pal::string_t& file = files[i];
+        for (size_t rank = 0; rank < managed_ext_count; ++rank)
         {
             // Nothing to do if file length is smaller than expected ext.
-            if (file.length() <= ext.length())
+            size_t ext_length = managed_ext_length[rank];
+            if (file.length() <= ext_length ||
+                pal::strcasecmp(file.c_str() + file.length() - ext_length, managed_ext[rank]) != 0)
             {
                 continue;
             }
+            candidates.push_back({ i, file.length() - ext_length, rank });
+        }
+    }
 
-            auto file_name = file.substr(0, file.length() - ext.length());
-            auto file_ext = file.substr(file_name.length());
-
-            // Ext did not match expected ext, skip this file.
-            if (pal::strcasecmp(file_ext.c_str(), ext.c_str()))
-            {
-                continue;
-            }
+    // Group the candidates by simple name, best ranked first.
+    auto compare_names = [&files](const dir_assembly_t& a, const dir_assembly_t& b) -> int
+    {
+        return files[a.file].compare(0, a.name_length, files[b.file], 0, b.name_length);
+    };
+    std::sort(candidates.begin(), candidates.end(), [&compare_names](const dir_assembly_t& a, const dir_assembly_t& b)
+    {
+        int compare = compare_names(a, b);
+        if (compare != 0)
+        {
+            return compare < 0;
+        }
+        return (a.rank != b.rank) ? (a.rank < b.rank) : (a.file < b.file);
+    });
 
+    std::vector<dir_assembly_t> winners;
+    winners.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        if (i > 0 && compare_names(candidates[i - 1], candidates[i]) == 0)
+        {
             // Already added entry for this asset, by priority order skip this ext
-            if (dir_assemblies->count(file_name))
-            {
-                trace::verbose(_X("Skipping %s because the %s already exists in %s assemblies"), file.c_str(), dir_assemblies->find(file_name)->second.c_str(), dir_name.c_str());
-                continue;
-            }
-
-            // Add entry for this asset
-            pal::string_t file_path = dir + DIR_SEPARATOR + file;
-            trace::verbose(_X("Adding %s to %s assembly set from %s"), file_name.c_str(), dir_name.c_str(), file_path.c_str());
-            dir_assemblies->emplace(file_name, file_path);
+            trace::verbose(_X("Skipping %s because the %s already exists in %s assemblies"), files[candidates[i].file].c_str(), files[winners.back().file].c_str(), dir_name.c_str());
+            continue;
         }
+        winners.push_back(candidates[i]);
+    }
+    std::sort(winners.begin(), winners.end(), [](const dir_assembly_t& a, const dir_assembly_t& b)
+    {
+        return (a.rank != b.rank) ? (a.rank < b.rank) : (a.file < b.file);
+    });
+
+    for (const auto& winner : winners)
+    {
+        // Add entry for this asset
+        const pal::string_t& file = files[winner.file];
+        pal::string_t file_path;
+        file_path.reserve(dir.length() + 1 + file.length());
+        file_path.append(dir).push_back(DIR_SEPARATOR);
+        file_path.append(file);
+        pal::string_t file_name = file.substr(0, winner.name_length);
+        trace::verbose(_X("Adding %s to %s assembly set from %s"), file_name.c_str(), dir_name.c_str(), file_path.c_str());
+        dir_assemblies->emplace(std::move(file_name), std::move(file_path));
     }
 }
 
@@ -159,6 +283,7 @@ bool deps_resolver_t::try_roll_forward(const deps_entry_t& entry,
         pal::string_t cache_key = path;
         append_path(&cache_key, maj_min_pat_star.c_str());
 
+        std::unique_lock<std::mutex> lock(m_roll_forward_lock);
         if (m_prerelease_roll_forward_cache.count(cache_key))
         {
             max_str = m_prerelease_roll_forward_cache[cache_key];
@@ -166,7 +291,9 @@ bool deps_resolver_t::try_roll_forward(const deps_entry_t& entry,
         }
         else
         {
+            lock.unlock();
             try_prerelease_roll_forward_in_dir(path, cur_ver, &max_str);
+            lock.lock();
             m_prerelease_roll_forward_cache[cache_key] = max_str;
         }
     }
@@ -178,6 +305,7 @@ bool deps_resolver_t::try_roll_forward(const deps_entry_t& entry,
         pal::string_t cache_key = path;
         append_path(&cache_key, maj_min_star.c_str());
 
+        std::unique_lock<std::mutex> lock(m_roll_forward_lock);
         if (m_patch_roll_forward_cache.count(cache_key))
         {
             max_str = m_patch_roll_forward_cache[cache_key];
@@ -185,13 +313,15 @@ bool deps_resolver_t::try_roll_forward(const deps_entry_t& entry,
         }
         else
         {
+            lock.unlock();
             try_patch_roll_forward_in_dir(path, cur_ver, &max_str);
+            lock.lock();
             m_patch_roll_forward_cache[cache_key] = max_str;
         }
     }
     append_path(&path, max_str.c_str());
 
-    return entry.to_rel_path(path, candidate);
+    return entry.to_rel_path(path, candidate, &m_dir_cache);
 }
 
 void deps_resolver_t::setup_probe_config(
@@ -234,11 +364,13 @@ void deps_resolver_t::setup_probe_config(
         m_probes.push_back(probe_config_t::fx(m_fx_dir, m_fx_deps.get()));
     }
 
+    m_first_additional_probe = m_probes.size();
     for (const auto& probe : m_additional_probes)
     {
         // Additional paths
         m_probes.push_back(probe_config_t::additional(probe));
     }
+    m_additional_probe_index.set_roots(m_additional_probes);
 
     if (trace::is_enabled())
     {
@@ -250,6 +382,82 @@ void deps_resolver_t::setup_probe_config(
     }
 }
 
+// -----------------------------------------------------------------------------
+// Load the deps files of a portable app and its framework.
+//
+// Description:
+//    Only the app's RID fallback needs the framework's RID fallback graph, so the
+//    framework deps file is loaded on a separate thread while the app deps file is
+//    parsed. The app deps are resolved against the graph once the thread is done.
+//
+void deps_resolver_t::load_portable_deps(const hostpolicy_init_t& init)
+{
+    m_deps = std::unique_ptr<deps_json_t>(new deps_json_t());
+    m_fx_deps = std::unique_ptr<deps_json_t>(new deps_json_t());
+
+    deps_json_t* fx_deps = m_fx_deps.get();
+    const pal::string_t& fx_deps_file = m_fx_deps_file;
+    json_scanner::range_t fx_deps_data = get_deps_data(init, fx_deps_file);
+    auto load_fx_deps = [fx_deps, &fx_deps_file, fx_deps_data]() {
+        if (fx_deps->parse(false, fx_deps_file, fx_deps_data))
+        {
+            fx_deps->resolve(fx_deps->get_rid_fallback_graph());
+        }
+    };
+
+    std::thread fx_loader;
+    try
+    {
+        fx_loader = std::thread(load_fx_deps);
+    }
+    catch (const std::system_error&)
+    {
+        trace::verbose(_X("Could not start a thread to load the FX deps file, loading it inline"));
+        load_fx_deps();
+    }
+
+    m_deps->parse(true, m_deps_file, get_deps_data(init, m_deps_file));
+
+    if (fx_loader.joinable())
+    {
+        fx_loader.join();
+    }
+
+    m_deps->resolve(m_fx_deps->get_rid_fallback_graph());
+}
+
+// -----------------------------------------------------------------------------
+// Load the deps file of a standalone app.
+//
+void deps_resolver_t::load_standalone_deps(const hostpolicy_init_t& init)
+{
+    m_deps = std::unique_ptr<deps_json_t>(new deps_json_t());
+    if (m_deps->parse(false, m_deps_file, get_deps_data(init, m_deps_file)))
+    {
+        m_deps->resolve(m_deps->get_rid_fallback_graph() /* unused */);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Keep a report of the resolution if COREHOST_RESOLVE_REPORT asks for one.
+//
+void deps_resolver_t::setup_report()
+{
+    pal::string_t report_file;
+    if (!resolve_report_t::get_report_file(&report_file))
+    {
+        return;
+    }
+
+    m_report.reset(new resolve_report_t(report_file));
+    std::vector<pal::string_t> probe_dirs;
+    for (const auto& config : m_probes)
+    {
+        probe_dirs.push_back(config.probe_dir);
+    }
+    m_report->set_probe_dirs(probe_dirs);
+}
+
 void deps_resolver_t::setup_additional_probes(const std::vector<pal::string_t>& probe_paths)
 {
     m_additional_probes.assign(probe_paths.begin(), probe_paths.end());
@@ -267,11 +475,242 @@ void deps_resolver_t::setup_additional_probes(const std::vector<pal::string_t>&
     }
 }
 
+// -----------------------------------------------------------------------------
+// Whether the directory of the entry's package exists in the package layout
+// under "probe_dir", from the listings of the probe root and of the package's
+// directory. The version directory is only checked if "check_version" is set,
+// since a roll forward looks for other versions.
+//
+bool deps_resolver_t::has_package_dir(const pal::string_t& probe_dir, const deps_entry_t& entry, bool check_version)
+{
+    if (!m_dir_cache.contains(probe_dir, entry.library_name))
+    {
+        return false;
+    }
+    if (!check_version)
+    {
+        return true;
+    }
+
+    pal::string_t package_dir = probe_dir;
+    append_path(&package_dir, entry.library_name.c_str());
+    return m_dir_cache.contains(package_dir, entry.library_version);
+}
+
+// -----------------------------------------------------------------------------
+// The index of the servicing store at "probe_dir", read on first use.
+//
+const servicing_index_t& deps_resolver_t::get_servicing_index(const pal::string_t& probe_dir)
+{
+    std::lock_guard<std::mutex> lock(m_index_lock);
+    auto iter = m_servicing_indexes.find(probe_dir);
+    if (iter == m_servicing_indexes.end())
+    {
+        iter = m_servicing_indexes.emplace(probe_dir, servicing_index_t()).first;
+        iter->second.load(probe_dir);
+    }
+    return iter->second;
+}
+
+// -----------------------------------------------------------------------------
+// The hash index of the cache at "probe_dir", opened on first use, or nullptr
+// if the cache has no current index.
+//
+const hash_index_t* deps_resolver_t::get_hash_index(const pal::string_t& probe_dir)
+{
+    std::lock_guard<std::mutex> lock(m_index_lock);
+    auto iter = m_hash_indexes.find(probe_dir);
+    if (iter == m_hash_indexes.end())
+    {
+        std::unique_ptr<hash_index_t> index(new hash_index_t());
+        if (!index->open(probe_dir))
+        {
+            index.reset();
+        }
+        iter = m_hash_indexes.emplace(probe_dir, std::move(index)).first;
+    }
+    return iter->second.get();
+}
+
+// -----------------------------------------------------------------------------
+// The probe filter of the package layout at "probe_dir", read on first use,
+// or nullptr if there is no current one.
+//
+const probe_filter_t* deps_resolver_t::get_probe_filter(const pal::string_t& probe_dir)
+{
+    std::lock_guard<std::mutex> lock(m_index_lock);
+    auto iter = m_probe_filters.find(probe_dir);
+    if (iter == m_probe_filters.end())
+    {
+        std::unique_ptr<probe_filter_t> filter(new probe_filter_t());
+        if (!filter->load(probe_dir))
+        {
+            filter.reset();
+        }
+        iter = m_probe_filters.emplace(probe_dir, std::move(filter)).first;
+    }
+    return iter->second.get();
+}
+
+// -----------------------------------------------------------------------------
+// Probe for the entry in a single probe configuration.
+//
+bool deps_resolver_t::probe_entry_in_config(const deps_entry_t& entry, const probe_config_t& config, pal::string_t* candidate)
+{
+    const pal::string_t& probe_dir = config.probe_dir;
+    candidate->clear();
+
+    // Probes in a package layout need the package directory, and most of them
+    // miss because it is not there. Servicing stores are indexed up front.
+    if (config.only_serviceable_assets)
+    {
+        if (!get_servicing_index(probe_dir).contains(entry.library_name, entry.library_version))
+        {
+            trace::verbose(_X("    Skipping... package [%s/%s] not serviced"), entry.library_name.c_str(), entry.library_version.c_str());
+            return false;
+        }
+    }
+    else if (config.probe_deps_json == nullptr && !has_package_dir(probe_dir, entry, !config.is_roll_fwd_set()))
+    {
+        trace::verbose(_X("    Skipping... package [%s/%s] not in probe dir"), entry.library_name.c_str(), entry.library_version.c_str());
+        return false;
+    }
+
+    if (config.match_hash)
+    {
+        // The hash index of the cache, if there is a current one, saves reading
+        // the hash file of the package.
+        const hash_index_t* index = get_hash_index(probe_dir);
+        hash_index_t::match_t match = (index == nullptr) ? hash_index_t::not_indexed :
+            index->match(entry.library_name, entry.library_version, entry.library_hash);
+        if (match == hash_index_t::matched && entry.to_full_path(probe_dir, candidate, &m_dir_cache))
+        {
+            assert(!config.is_roll_fwd_set());
+            trace::verbose(_X("    Matched indexed hash for [%s]"), candidate->c_str());
+            return true;
+        }
+        // Without the index, the hash files are read one at a time, as only
+        // queries of whether files exist are batched. They are still read on
+        // the probing threads, but not while collecting the queries.
+        if (match == hash_index_t::not_indexed && !m_dir_cache.is_collecting() && entry.to_hash_matched_path(probe_dir, candidate, &m_dir_cache))
+        {
+            assert(!config.is_roll_fwd_set());
+            trace::verbose(_X("    Matched hash for [%s]"), candidate->c_str());
+            return true;
+        }
+        trace::verbose(_X("    Skipping... match hash failed"));
+    }
+    else if (config.probe_deps_json)
+    {
+        // If the deps json has it then someone has already done rid selection and put the right stuff in the dir.
+        // So checking just package name and version would suffice. No need to check further for the exact asset relative path.
+        if (config.probe_deps_json->has_package(entry.library_name, entry.library_version) && entry.to_dir_path(probe_dir, candidate, &m_dir_cache))
+        {
+            trace::verbose(_X("    Probed deps json and matched [%s]"), candidate->c_str());
+            return true;
+        }
+        trace::verbose(_X("    Skipping... probe in deps json failed"));
+    }
+    else if (!config.is_roll_fwd_set())
+    {
+        const probe_filter_t* filter = get_probe_filter(probe_dir);
+        if (filter != nullptr && filter->excludes(entry.library_name, entry.library_version, entry.relative_path))
+        {
+            trace::verbose(_X("    Skipping... not in the probe filter of the probe dir"));
+        }
+        else if (entry.to_full_path(probe_dir, candidate, &m_dir_cache))
+        {
+            trace::verbose(_X("    Specified no roll forward; matched [%s]"), candidate->c_str());
+            return true;
+        }
+        trace::verbose(_X("    Skipping... not found in probe dir"));
+    }
+    else if (config.is_roll_fwd_set())
+    {
+        if (try_roll_forward(entry, probe_dir, config.patch_roll_fwd, config.prerelease_roll_fwd, candidate))
+        {
+            trace::verbose(_X("    Specified roll forward; matched [%s]"), candidate->c_str());
+            return true;
+        }
+        trace::verbose(_X("    Skipping... could not roll forward and match in probe dir"));
+    }
+    candidate->clear();
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Probe for the entry in the probe configurations in priority order.
+//
+// Description:
+//    The TPA, native and resources passes and the CoreCLR lookup probe many of
+//    the same entries, so the outcome of probing an entry in a configuration,
+//    found or not, is kept for the rest of the run. Entries are keyed by
+//    library name, version, relative path and hash, since the hash decides
+//    the outcome in hash matching configurations.
+//
 bool deps_resolver_t::probe_entry_in_configs(const deps_entry_t& entry, pal::string_t* candidate)
+{
+    return probe_entry_in_configs(entry, m_probes.size(), candidate, nullptr);
+}
+
+bool deps_resolver_t::probe_entry_in_configs(const deps_entry_t& entry, size_t end, pal::string_t* candidate, size_t* found_config)
+{
+    std::vector<probe_result_t>& results = m_probe_results[get_probe_key(entry)];
+    results.resize(m_probes.size());
+    bool found = probe_entry_in_configs(entry, &results, end, candidate, found_config);
+    if (m_report)
+    {
+        report_probes(entry, &results);
+    }
+    return found;
+}
+
+// -----------------------------------------------------------------------------
+// Add the probes of the entry to the report, costing the ones that were not
+// reported before in the pass that made them.
+//
+void deps_resolver_t::report_probes(const deps_entry_t& entry, std::vector<probe_result_t>* results)
+{
+    std::vector<resolve_report_t::probe_t> probes;
+    for (size_t i = 0; i < results->size(); ++i)
+    {
+        probe_result_t& result = (*results)[i];
+        if (!result.probed)
+        {
+            continue;
+        }
+        probes.push_back({ i, result.found, result.reported, result.ns, result.io });
+        result.reported = true;
+    }
+    m_report->add_entry(entry, probes);
+}
+
+pal::string_t deps_resolver_t::get_probe_key(const deps_entry_t& entry)
+{
+    pal::string_t key;
+    key.reserve(entry.library_name.length() + entry.library_version.length() + entry.relative_path.length() + entry.library_hash.length() + 3);
+    key.append(entry.library_name);
+    key.push_back(_X('/'));
+    key.append(entry.library_version);
+    key.push_back(_X('/'));
+    key.append(entry.relative_path);
+    key.push_back(_X('\0'));
+    key.append(entry.library_hash);
+    return key;
+}
+
+bool deps_resolver_t::probe_entry_in_configs(const deps_entry_t& entry, std::vector<probe_result_t>* results, size_t end, pal::string_t* candidate, size_t* found_config)
 {
     candidate->clear();
-    for (const auto& config : m_probes)
+
+    // The additional probe dirs that have the package version, looked up once
+    // for all of them.
+    bool has_additional_mask = false;
+    uint64_t additional_mask = 0;
+
+    for (size_t i = 0; i < end && i < m_probes.size(); ++i)
     {
+        const probe_config_t& config = m_probes[i];
         trace::verbose(_X("  Considering entry [%s/%s/%s] and probe dir [%s]"), entry.library_name.c_str(), entry.library_version.c_str(), entry.relative_path.c_str(), config.probe_dir.c_str());
 
         if (config.only_serviceable_assets && !entry.is_serviceable)
@@ -284,50 +723,253 @@ bool deps_resolver_t::probe_entry_in_configs(const deps_entry_t& entry, pal::str
             trace::verbose(_X("    Skipping... not runtime asset"));
             continue;
         }
-        pal::string_t probe_dir = config.probe_dir;
-        if (config.match_hash)
+
+        size_t additional = i - m_first_additional_probe;
+        if (i >= m_first_additional_probe && additional < probe_index_t::max_roots)
         {
-            if (entry.to_hash_matched_path(probe_dir, candidate))
+            if (!has_additional_mask)
             {
-                assert(!config.is_roll_fwd_set());
-                trace::verbose(_X("    Matched hash for [%s]"), candidate->c_str());
-                return true;
+                additional_mask = m_additional_probe_index.find(entry.library_name, entry.library_version, &m_dir_cache);
+                has_additional_mask = true;
             }
-            trace::verbose(_X("    Skipping... match hash failed"));
+            if ((additional_mask & (1ULL << additional)) == 0)
+            {
+                trace::verbose(_X("    Skipping... package [%s/%s] not in probe dir"), entry.library_name.c_str(), entry.library_version.c_str());
+                continue;
+            }
+        }
+
+        probe_result_t& result = (*results)[i];
+        if (!result.probed && m_report)
+        {
+            // The file system calls are counted per thread, and the probe
+            // runs on this one.
+            pal::io_counters_t io = pal::get_io_counters();
+            auto start = std::chrono::steady_clock::now();
+            result.found = probe_entry_in_config(entry, config, &result.candidate);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            const pal::io_counters_t& now = pal::get_io_counters();
+            result.ns = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+            result.io.stats = now.stats - io.stats;
+            result.io.dirs = now.dirs - io.dirs;
+            result.io.opens = now.opens - io.opens;
+            result.io.batches = now.batches - io.batches;
+            result.probed = true;
+        }
+        else if (!result.probed)
+        {
+            result.found = probe_entry_in_config(entry, config, &result.candidate);
+            result.probed = true;
+        }
+        else
+        {
+            trace::verbose(_X("    Using the earlier probe result [%s]"), result.found ? result.candidate.c_str() : _X("not found"));
         }
-        else if (config.probe_deps_json)
+
+        // Files are taken to exist while they are collected, so the configs
+        // that follow are probed too, for their files to be queried as well.
+        if (result.found && !m_dir_cache.is_collecting())
         {
-            // If the deps json has it then someone has already done rid selection and put the right stuff in the dir.
-            // So checking just package name and version would suffice. No need to check further for the exact asset relative path.
-            if (config.probe_deps_json->has_package(entry.library_name, entry.library_version) && entry.to_dir_path(probe_dir, candidate))
+            candidate->assign(result.candidate);
+            if (found_config != nullptr)
             {
-                trace::verbose(_X("    Probed deps json and matched [%s]"), candidate->c_str());
-                return true;
+                *found_config = i;
             }
-            trace::verbose(_X("    Skipping... probe in deps json failed"));
+            return true;
         }
-        else if (!config.is_roll_fwd_set())
+
+        // continue to try next probe config
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Probe the entries on worker threads ahead of a resolution pass.
+//
+// Description:
+//    Probing is mostly waiting on the file system, so the entries not probed
+//    yet are probed in parallel and their results kept like any other probe
+//    results. The pass then goes through the entries in order as before and
+//    finds them probed, so the paths it resolves and their order do not
+//    change. Each entry has its own results, so the workers only share the
+//    directory cache and the indexes, which have locks of their own. Where
+//    the file system can be queried in batches, the files are queried up
+//    front and the entries are probed even if threads do not pay off.
+//
+//    Without tracing only, so that the trace of the probes stays in order.
+//
+void deps_resolver_t::prefetch_probes(const std::vector<deps_entry_t>& entries, const std::vector<deps_entry_t>& fx_entries)
+{
+    if (trace::is_enabled())
+    {
+        return;
+    }
+
+    struct probe_job_t
+    {
+        const deps_entry_t* entry;
+        std::vector<probe_result_t>* results;
+    };
+    std::vector<probe_job_t> jobs;
+    jobs.reserve(entries.size() + fx_entries.size());
+    auto add_jobs = [this, &jobs](const std::vector<deps_entry_t>& entries)
+    {
+        for (const auto& entry : entries)
         {
-            if (entry.to_full_path(probe_dir, candidate))
+            auto inserted = m_probe_results.emplace(get_probe_key(entry), std::vector<probe_result_t>());
+            if (inserted.second)
             {
-                trace::verbose(_X("    Specified no roll forward; matched [%s]"), candidate->c_str());
-                return true;
+                inserted.first->second.resize(m_probes.size());
+                jobs.push_back({ &entry, &inserted.first->second });
             }
-            trace::verbose(_X("    Skipping... not found in probe dir"));
         }
-        else if (config.is_roll_fwd_set())
+    };
+    add_jobs(entries);
+    add_jobs(fx_entries);
+
+    // Threads only pay off for enough entries. The workers mostly wait on the
+    // file system, so there are more of them than cores on small machines.
+    const size_t min_jobs_per_thread = 16;
+    const size_t min_threads = 4;
+    const size_t max_threads = 8;
+    size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), min_threads);
+    threads = std::min(std::min(threads, max_threads), jobs.size() / min_jobs_per_thread);
+    if (threads < 2 && !pal::is_batch_io_supported())
+    {
+        return;
+    }
+
+    // Runs "probe" on each of the jobs on the threads, this one included.
+    auto run_jobs = [&jobs, threads](const std::function<void(const probe_job_t&)>& probe)
+    {
+        std::atomic<size_t> next_job(0);
+        auto probe_jobs = [&jobs, &next_job, &probe]()
         {
-            if (try_roll_forward(entry, probe_dir, config.patch_roll_fwd, config.prerelease_roll_fwd, candidate))
+            for (size_t i = next_job++; i < jobs.size(); i = next_job++)
             {
-                trace::verbose(_X("    Specified roll forward; matched [%s]"), candidate->c_str());
-                return true;
+                probe(jobs[i]);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; ++i)
+        {
+            try
+            {
+                workers.push_back(std::thread(probe_jobs));
+            }
+            catch (const std::system_error&)
+            {
+                break;
             }
-            trace::verbose(_X("    Skipping... could not roll forward and match in probe dir"));
         }
+        probe_jobs();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    };
 
-        // continue to try next probe config
+    // Where the file system can be queried in batches, the files the probes
+    // would look at one by one are gathered first, by probing with each file
+    // taken to exist, and queried together. The probes then find them
+    // answered. The files of every config an entry could be found in are
+    // gathered, rather than up to the first, and the package directories are
+    // listed meanwhile, on the same threads as the probes.
+    if (!jobs.empty() && pal::is_batch_io_supported())
+    {
+        std::vector<pal::string_t> paths;
+        m_dir_cache.set_collector(&paths);
+        run_jobs([this](const probe_job_t& job)
+        {
+            std::vector<probe_result_t> results(m_probes.size());
+            pal::string_t candidate;
+            probe_entry_in_configs(*job.entry, &results, m_probes.size(), &candidate, nullptr);
+        });
+        m_dir_cache.set_collector(nullptr);
+
+        std::vector<bool> exists;
+        if (!paths.empty() && pal::file_exists_batch(paths, &exists))
+        {
+            m_dir_cache.add_file_states(paths, exists);
+        }
+    }
+
+    run_jobs([this](const probe_job_t& job)
+    {
+        pal::string_t candidate;
+        probe_entry_in_configs(*job.entry, job.results, m_probes.size(), &candidate, nullptr);
+    });
+}
+
+// -----------------------------------------------------------------------------
+// The files and directories the resolution read or looked into, so far.
+//
+// Description:
+//    Adding, removing or renaming an entry of a directory changes its stamp,
+//    so the outcome of the resolution can only change if the stamp of one of
+//    these changes. The deps files, the directories probed, the package
+//    directories listed to roll forward and the directories of the servicing
+//    indexes are included. The probe filters take package version
+//    directories not to change and add none.
+//
+void deps_resolver_t::get_dependencies(std::vector<pal::string_t>* paths)
+{
+    std::unordered_set<pal::string_t> seen;
+    auto add = [paths, &seen](const pal::string_t& path)
+    {
+        if (!path.empty() && seen.insert(path).second)
+        {
+            paths->push_back(path);
+        }
+    };
+
+    add(m_deps_file);
+    add(m_fx_deps_file);
+    add(m_app_dir);
+    add(m_fx_dir);
+    for (const auto& config : m_probes)
+    {
+        add(config.probe_dir);
+        if (config.match_hash)
+        {
+            add(hash_index_t::get_index_file(config.probe_dir));
+        }
+    }
+
+    std::vector<pal::string_t> dirs;
+    m_dir_cache.get_dirs(&dirs);
+    for (const auto& index : m_servicing_indexes)
+    {
+        index.second.get_dirs(&dirs);
+    }
+    for (const auto& cached : m_patch_roll_forward_cache)
+    {
+        dirs.push_back(get_directory(cached.first));
+    }
+    for (const auto& cached : m_prerelease_roll_forward_cache)
+    {
+        dirs.push_back(get_directory(cached.first));
+    }
+    for (const auto& dir : dirs)
+    {
+        add(dir);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// The root and package directories of the servicing stores, indexing the ones
+// no entry was probed in yet.
+//
+void deps_resolver_t::get_servicing_dependencies(std::vector<pal::string_t>* paths)
+{
+    for (const auto& config : m_probes)
+    {
+        if (config.only_serviceable_assets)
+        {
+            get_servicing_index(config.probe_dir).get_dirs(paths);
+        }
     }
-    return false;
 }
 
 // -----------------------------------------------------------------------------
@@ -339,6 +981,10 @@ bool deps_resolver_t::probe_entry_in_configs(const deps_entry_t& entry, pal::str
 //
 pal::string_t deps_resolver_t::resolve_coreclr_dir()
 {
+    if (m_report)
+    {
+        m_report->begin_pass(_X("coreclr"));
+    }
     trace::verbose(_X("--- Resolving CoreCLR directory ---"));
 
     auto process_coreclr = [&]
@@ -353,7 +999,7 @@ pal::string_t deps_resolver_t::resolve_coreclr_dir()
             {
                 return get_directory(candidate);
             }
-            else if (entry.is_rid_specific && entry.to_rel_path(deps_dir, &candidate))
+            else if (entry.is_rid_specific && entry.to_rel_path(deps_dir, &candidate, &m_dir_cache))
             {
                 return get_directory(candidate);
             }
@@ -380,19 +1026,21 @@ pal::string_t deps_resolver_t::resolve_coreclr_dir()
         trace::info(_X("-- Starting CoreCLR Probe from FX deps.json"));
         clr_dir = process_coreclr(false, m_fx_dir, m_fx_deps.get());
     }
-    if (!clr_dir.empty())
+    if (clr_dir.empty())
     {
-        return clr_dir;
+        // Use platform-specific search algorithm
+        pal::string_t install_dir;
+        if (pal::find_coreclr(&install_dir))
+        {
+            clr_dir = install_dir;
+        }
     }
 
-    // Use platform-specific search algorithm
-    pal::string_t install_dir;
-    if (pal::find_coreclr(&install_dir))
+    if (m_report)
     {
-        return install_dir;
+        m_report->end_pass();
     }
-
-    return pal::string_t();
+    return clr_dir;
 }
 
 void deps_resolver_t::resolve_tpa_list(
@@ -410,16 +1058,61 @@ void deps_resolver_t::resolve_tpa_list(
         get_dir_assemblies(m_fx_dir, _X("fx"), &m_fx_assemblies);
     }
 
-    std::unordered_set<pal::string_t> items;
+    const auto& deps_entries = m_deps->get_entries(deps_entry_t::asset_types::runtime);
+    const auto& fx_entries = m_portable ? m_fx_deps->get_entries(deps_entry_t::asset_types::runtime) : empty;
+    prefetch_probes(deps_entries, fx_entries);
+
+    // Intern the names of all the assets up front, in the order they are added.
+    asset_name_table_t names(deps_entries.size() + m_local_assemblies.size() + fx_entries.size() + m_fx_assemblies.size());
 
-    auto process_entry = [&](const pal::string_t& deps_dir, deps_json_t* deps, const dir_assemblies_t& dir_assemblies, const deps_entry_t& entry)
+    typedef std::vector<std::pair<uint32_t, const pal::string_t*>> dir_asset_ids_t;
+    auto intern_entries = [&names](const std::vector<deps_entry_t>& entries, std::vector<uint32_t>* ids)
+    {
+        ids->reserve(entries.size());
+        for (const auto& entry : entries)
+        {
+            ids->push_back(names.intern(entry.asset_name));
+        }
+    };
+    auto intern_dir = [&names](const dir_assemblies_t& dir_assemblies, dir_asset_ids_t* ids)
+    {
+        ids->reserve(dir_assemblies.size());
+        for (const auto& kv : dir_assemblies)
+        {
+            ids->emplace_back(names.intern(kv.first), &kv.second);
+        }
+    };
+
+    std::vector<uint32_t> deps_ids, fx_ids;
+    dir_asset_ids_t local_ids, fx_dir_ids;
+    intern_entries(deps_entries, &deps_ids);
+    intern_dir(m_local_assemblies, &local_ids);
+    intern_entries(fx_entries, &fx_ids);
+    intern_dir(m_fx_assemblies, &fx_dir_ids);
+
+    // Paths of the directory assemblies by asset name id.
+    std::vector<const pal::string_t*> local_paths(names.size()), fx_paths(names.size());
+    for (const auto& asset : local_ids)
+    {
+        local_paths[asset.first] = asset.second;
+    }
+    for (const auto& asset : fx_dir_ids)
+    {
+        fx_paths[asset.first] = asset.second;
+    }
+
+    std::vector<bool> items(names.size());
+    std::vector<pal::string_t> real_paths(names.size());
+    path_list_builder_t paths;
+
+    auto process_entry = [&](const pal::string_t& deps_dir, const std::vector<const pal::string_t*>& dir_paths, const deps_entry_t& entry, uint32_t asset_id)
     {
         if (entry.is_serviceable)
         {
             breadcrumb->insert(entry.library_name + _X(",") + entry.library_version);
             breadcrumb->insert(entry.library_name);
         }
-        if (items.count(entry.asset_name))
+        if (items[asset_id])
         {
             return;
         }
@@ -430,17 +1123,17 @@ void deps_resolver_t::resolve_tpa_list(
         // Try to probe from the shared locations.
         if (probe_entry_in_configs(entry, &candidate))
         {
-            add_tpa_asset(entry.asset_name, candidate, &items, output);
+            add_tpa_asset(asset_id, candidate, &items, &real_paths, &paths);
         }
         // The rid asset should be picked up from app relative subpath.
-        else if (entry.is_rid_specific && entry.to_rel_path(deps_dir, &candidate))
+        else if (entry.is_rid_specific && entry.to_rel_path(deps_dir, &candidate, &m_dir_cache))
         {
-            add_tpa_asset(entry.asset_name, candidate, &items, output);
+            add_tpa_asset(asset_id, candidate, &items, &real_paths, &paths);
         }
         // The rid-less asset should be picked up from the app base.
-        else if (dir_assemblies.count(entry.asset_name))
+        else if (dir_paths[asset_id] != nullptr)
         {
-            add_tpa_asset(entry.asset_name, dir_assemblies.find(entry.asset_name)->second, &items, output);
+            add_tpa_asset(asset_id, *dir_paths[asset_id], &items, &real_paths, &paths);
         }
         else
         {
@@ -448,28 +1141,30 @@ void deps_resolver_t::resolve_tpa_list(
             trace::warning(_X("Could not resolve path to assembly: [%s, %s, %s]"), entry.library_name.c_str(), entry.library_version.c_str(), entry.relative_path.c_str());
         }
     };
-    
-    const auto& deps_entries = m_deps->get_entries(deps_entry_t::asset_types::runtime);
-    std::for_each(deps_entries.begin(), deps_entries.end(), [&](const deps_entry_t& entry) {
-        process_entry(m_app_dir, m_deps.get(), m_local_assemblies, entry);
-    });
+
+    for (size_t i = 0; i < deps_entries.size(); ++i)
+    {
+        process_entry(m_app_dir, local_paths, deps_entries[i], deps_ids[i]);
+    }
 
     // Finally, if the deps file wasn't present or has missing entries, then
     // add the app local assemblies to the TPA.
-    for (const auto& kv : m_local_assemblies)
+    for (const auto& asset : local_ids)
     {
-        add_tpa_asset(kv.first, kv.second, &items, output);
+        add_tpa_asset(asset.first, *asset.second, &items, &real_paths, &paths);
     }
 
-    const auto& fx_entries = m_portable ? m_fx_deps->get_entries(deps_entry_t::asset_types::runtime) : empty;
-    std::for_each(fx_entries.begin(), fx_entries.end(), [&](const deps_entry_t& entry) {
-        process_entry(m_fx_dir, m_fx_deps.get(), m_fx_assemblies, entry);
-    });
+    for (size_t i = 0; i < fx_entries.size(); ++i)
+    {
+        process_entry(m_fx_dir, fx_paths, fx_entries[i], fx_ids[i]);
+    }
 
-    for (const auto& kv : m_fx_assemblies)
+    for (const auto& asset : fx_dir_ids)
     {
-        add_tpa_asset(kv.first, kv.second, &items, output);
+        add_tpa_asset(asset.first, *asset.second, &items, &real_paths, &paths);
     }
+
+    paths.build(output);
 }
 
 // -----------------------------------------------------------------------------
@@ -512,17 +1207,68 @@ void deps_resolver_t::resolve_probe_dirs(
         return get_directory(str);
     };
     std::function<pal::string_t(const pal::string_t&)>& action = is_resources ? resources : native;
-    std::unordered_set<pal::string_t> items;
+    unique_paths_t items;
     pal::string_t core_servicing = m_core_servicing;
     pal::realpath(&core_servicing);
-    pal::string_t non_serviced;
+    path_list_builder_t paths, non_serviced;
 
     std::vector<deps_entry_t> empty(0);
     const auto& entries = m_deps->get_entries(asset_type);
     const auto& fx_entries = m_portable ? m_fx_deps->get_entries(asset_type) : empty;
 
+    // A package has its resources in one directory per culture under a base
+    // directory, which is usually where all of them are found. Only the first
+    // entry of each package version is probed up front, and the base directory
+    // is derived from the file found. The other cultures are probed in the
+    // configs before the one it was found in, and looked for in the listing of
+    // the base directory; a culture that is not there is probed in the rest,
+    // and its own base directory added. A servicing store that patches some
+    // cultures only is then used for them as before.
+    std::vector<deps_entry_t> first_entries, first_fx_entries;
+    if (is_resources)
+    {
+        auto get_first_entries = [](const std::vector<deps_entry_t>& entries, std::vector<deps_entry_t>* first_entries)
+        {
+            std::unordered_set<pal::string_t> packages;
+            for (const auto& entry : entries)
+            {
+                if (packages.insert(entry.library_name + _X("/") + entry.library_version).second)
+                {
+                    first_entries->push_back(entry);
+                }
+            }
+        };
+        get_first_entries(entries, &first_entries);
+        get_first_entries(fx_entries, &first_fx_entries);
+        prefetch_probes(first_entries, first_fx_entries);
+    }
+    else
+    {
+        prefetch_probes(entries, fx_entries);
+    }
+
     pal::string_t candidate;
 
+    // Package version -> the config its first resources entry was found in,
+    // and the base directory there.
+    struct resource_base_t
+    {
+        size_t config;
+        pal::string_t dir;
+    };
+    std::unordered_map<pal::string_t, resource_base_t> resource_bases;
+    auto get_culture = [](const pal::string_t& relative_path) -> pal::string_t
+    {
+        size_t file_start = relative_path.find_last_of(_X("/\\"));
+        if (file_start == pal::string_t::npos || file_start == 0)
+        {
+            return pal::string_t();
+        }
+        size_t culture_start = relative_path.find_last_of(_X("/\\"), file_start - 1);
+        culture_start = (culture_start == pal::string_t::npos) ? 0 : culture_start + 1;
+        return relative_path.substr(culture_start, file_start - culture_start);
+    };
+
     bool track_api_sets = true;
     auto add_package_cache_entry = [&](const deps_entry_t& entry)
     {
@@ -532,7 +1278,35 @@ void deps_resolver_t::resolve_probe_dirs(
             breadcrumb->insert(entry.library_name);
         }
 
-        if (probe_entry_in_configs(entry, &candidate))
+        pal::string_t package_key;
+        auto base = resource_bases.end();
+        if (is_resources)
+        {
+            package_key = entry.library_name + _X("/") + entry.library_version;
+            base = resource_bases.find(package_key);
+        }
+
+        size_t config = 0;
+        bool found;
+        if (base == resource_bases.end())
+        {
+            found = probe_entry_in_configs(entry, m_probes.size(), &candidate, &config);
+        }
+        else
+        {
+            found = probe_entry_in_configs(entry, base->second.config, &candidate, &config);
+            if (!found)
+            {
+                pal::string_t culture = get_culture(entry.relative_path);
+                if (!culture.empty() && m_dir_cache.contains(base->second.dir, culture))
+                {
+                    return;
+                }
+                found = probe_entry_in_configs(entry, m_probes.size(), &candidate, &config);
+            }
+        }
+
+        if (found)
         {
             // For standalone apps, on win7, coreclr needs ApiSets which has to be in the DLL search path.
             const pal::string_t result_dir = action(candidate);
@@ -550,7 +1324,11 @@ void deps_resolver_t::resolve_probe_dirs(
                 m_api_set_paths.insert(result_dir);
             }
 
-            add_unique_path(asset_type, result_dir, &items, output, &non_serviced, core_servicing);
+            add_unique_path(asset_type, result_dir, &items, &paths, &non_serviced, core_servicing);
+            if (is_resources)
+            {
+                resource_bases.emplace(package_key, resource_base_t { config, result_dir });
+            }
         }
     };
     std::for_each(entries.begin(), entries.end(), add_package_cache_entry);
@@ -563,9 +1341,9 @@ void deps_resolver_t::resolve_probe_dirs(
     {
         std::for_each(entries.begin(), entries.end(), [&](const deps_entry_t& entry)
         {
-            if (entry.is_rid_specific && entry.asset_type == asset_type && entry.to_rel_path(m_app_dir, &candidate))
+            if (entry.is_rid_specific && entry.asset_type == asset_type && entry.to_rel_path(m_app_dir, &candidate, &m_dir_cache))
             {
-                add_unique_path(asset_type, action(candidate), &items, output, &non_serviced, core_servicing);
+                add_unique_path(asset_type, action(candidate), &items, &paths, &non_serviced, core_servicing);
             }
 
             // App called out an explicit API set dependency.
@@ -580,7 +1358,7 @@ void deps_resolver_t::resolve_probe_dirs(
     track_api_sets = m_api_set_paths.empty();
 
     // App local path
-    add_unique_path(asset_type, m_app_dir, &items, output, &non_serviced, core_servicing);
+    add_unique_path(asset_type, m_app_dir, &items, &paths, &non_serviced, core_servicing);
 
     // If API sets is not found (i.e., empty) in the probe paths above:
     // 1. For standalone app, do nothing as all are sxs.
@@ -595,13 +1373,14 @@ void deps_resolver_t::resolve_probe_dirs(
         {
             m_api_set_paths.insert(m_fx_dir);
         }
-        add_unique_path(asset_type, m_fx_dir, &items, output, &non_serviced, core_servicing);
+        add_unique_path(asset_type, m_fx_dir, &items, &paths, &non_serviced, core_servicing);
     }
 
     // CLR path
-    add_unique_path(asset_type, clr_dir, &items, output, &non_serviced, core_servicing);
+    add_unique_path(asset_type, clr_dir, &items, &paths, &non_serviced, core_servicing);
 
-    output->append(non_serviced);
+    paths.append(non_serviced);
+    paths.build(output);
 }
 
 
@@ -619,8 +1398,25 @@ void deps_resolver_t::resolve_probe_dirs(
 //
 bool deps_resolver_t::resolve_probe_paths(const pal::string_t& clr_dir, probe_paths_t* probe_paths, std::unordered_set<pal::string_t>* breadcrumb)
 {
+    if (!m_report)
+    {
+        resolve_tpa_list(clr_dir, &probe_paths->tpa, breadcrumb);
+        resolve_probe_dirs(deps_entry_t::asset_types::native, clr_dir, &probe_paths->native, breadcrumb);
+        resolve_probe_dirs(deps_entry_t::asset_types::resources, clr_dir, &probe_paths->resources, breadcrumb);
+        return true;
+    }
+
+    m_report->begin_pass(_X("tpa"));
     resolve_tpa_list(clr_dir, &probe_paths->tpa, breadcrumb);
+    m_report->end_pass();
+    m_report->begin_pass(_X("native"));
     resolve_probe_dirs(deps_entry_t::asset_types::native, clr_dir, &probe_paths->native, breadcrumb);
+    m_report->end_pass();
+    m_report->begin_pass(_X("resources"));
     resolve_probe_dirs(deps_entry_t::asset_types::resources, clr_dir, &probe_paths->resources, breadcrumb);
+    m_report->end_pass();
+
+    // The resolution is done with the last pass.
+    m_report->write();
     return true;
 }
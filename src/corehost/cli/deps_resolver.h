@@ -5,12 +5,20 @@
 #define DEPS_RESOLVER_H
 
 #include <vector>
+#include <memory>
+#include <mutex>
 
 #include "pal.h"
 #include "args.h"
 #include "trace.h"
 #include "deps_format.h"
 #include "deps_entry.h"
+#include "dir_cache.h"
+#include "hash_index.h"
+#include "servicing_index.h"
+#include "probe_index.h"
+#include "probe_filter.h"
+#include "resolve_report.h"
 #include "runtime_config.h"
 
 // Probe paths to be resolved for ordering
@@ -27,6 +35,7 @@ public:
     deps_resolver_t(const hostpolicy_init_t& init, const arguments_t& args)
         : m_fx_dir(init.fx_dir)
         , m_app_dir(args.app_dir)
+        , m_first_additional_probe(0)
         , m_coreclr_index(-1)
         , m_portable(init.is_portable)
         , m_deps(nullptr)
@@ -39,18 +48,21 @@ public:
             m_fx_deps_file = get_fx_deps(m_fx_dir, init.fx_name);
             trace::verbose(_X("Using %s FX deps file"), m_fx_deps_file.c_str());
             trace::verbose(_X("Using %s deps file"), m_deps_file.c_str());
-            m_fx_deps = std::unique_ptr<deps_json_t>(new deps_json_t(false, m_fx_deps_file));
-            m_deps = std::unique_ptr<deps_json_t>(new deps_json_t(true, m_deps_file, m_fx_deps->get_rid_fallback_graph()));
+            load_portable_deps(init);
         }
         else
         {
-            m_deps = std::unique_ptr<deps_json_t>(new deps_json_t(false, m_deps_file));
+            load_standalone_deps(init);
         }
 
         setup_additional_probes(args.probe_paths);
         setup_probe_config(init, args);
+        setup_report();
     }
 
+    void load_portable_deps(const hostpolicy_init_t& init);
+    void load_standalone_deps(const hostpolicy_init_t& init);
+
     bool valid(pal::string_t* errors)
     {
         if (!m_deps->is_valid())
@@ -72,6 +84,8 @@ public:
 
     void setup_additional_probes(const std::vector<pal::string_t>& probe_paths);
 
+    void setup_report();
+
     bool resolve_probe_paths(
       const pal::string_t& clr_dir,
       probe_paths_t* probe_paths,
@@ -93,8 +107,38 @@ public:
     {
         return m_api_set_paths;
     }
+
+    // The files and directories the resolution depends on.
+    void get_dependencies(std::vector<pal::string_t>* paths);
+
+    // The directories of the servicing stores that a newly serviced package
+    // is added to.
+    void get_servicing_dependencies(std::vector<pal::string_t>* paths);
+
 private:
 
+    // Outcome of probing an entry in a probe configuration.
+    struct probe_result_t
+    {
+        bool probed;
+        bool found;
+        pal::string_t candidate;
+
+        // What the probe cost, with a report only.
+        bool reported;
+        uint64_t ns;
+        pal::io_counters_t io;
+
+        probe_result_t()
+            : probed(false)
+            , found(false)
+            , reported(false)
+            , ns(0)
+            , io()
+        {
+        }
+    };
+
     static pal::string_t get_fx_deps(const pal::string_t& fx_dir, const pal::string_t& fx_name)
     {
         pal::string_t fx_deps = fx_dir;
@@ -127,6 +171,60 @@ private:
         const deps_entry_t& entry,
         pal::string_t* candidate);
 
+    // Probe entry in the probe configurations before "end", and tell which
+    // one it was found in.
+    bool probe_entry_in_configs(
+        const deps_entry_t& entry,
+        size_t end,
+        pal::string_t* candidate,
+        size_t* found_config);
+
+    // Probe entry in the probe configurations before "end", with its results
+    // so far.
+    bool probe_entry_in_configs(
+        const deps_entry_t& entry,
+        std::vector<probe_result_t>* results,
+        size_t end,
+        pal::string_t* candidate,
+        size_t* found_config);
+
+    // Add the probe results of an entry to the report.
+    void report_probes(
+        const deps_entry_t& entry,
+        std::vector<probe_result_t>* results);
+
+    // The key of the probe results of an entry.
+    static pal::string_t get_probe_key(const deps_entry_t& entry);
+
+    // Probe the entries on worker threads.
+    void prefetch_probes(
+        const std::vector<deps_entry_t>& entries,
+        const std::vector<deps_entry_t>& fx_entries);
+
+    // Whether the package directory of the entry exists in a probe dir.
+    bool has_package_dir(
+        const pal::string_t& probe_dir,
+        const deps_entry_t& entry,
+        bool check_version);
+
+    // The index of the package versions in a servicing store.
+    const servicing_index_t& get_servicing_index(
+        const pal::string_t& probe_dir);
+
+    // The hash index of a hosting optimization cache, if it has a current one.
+    const hash_index_t* get_hash_index(
+        const pal::string_t& probe_dir);
+
+    // The probe filter of a probe dir, if it has a current one.
+    const probe_filter_t* get_probe_filter(
+        const pal::string_t& probe_dir);
+
+    // Probe entry in a single probe configuration.
+    bool probe_entry_in_config(
+        const deps_entry_t& entry,
+        const probe_config_t& config,
+        pal::string_t* candidate);
+
     // Try auto roll forward, if not return entry in probe dir.
     bool try_roll_forward(
         const deps_entry_t& entry,
@@ -146,6 +244,32 @@ private:
     dir_assemblies_t m_local_assemblies;
     dir_assemblies_t m_fx_assemblies;
 
+    // Probe results of the entries for the run, one per probe configuration.
+    std::unordered_map<pal::string_t, std::vector<probe_result_t>> m_probe_results;
+
+    // The report of the resolution, if one is asked for.
+    std::unique_ptr<resolve_report_t> m_report;
+
+    // Listings of the directories probed for the run.
+    dir_cache_t m_dir_cache;
+
+    // The additional probe dirs are the probe configurations from this index on.
+    size_t m_first_additional_probe;
+    probe_index_t m_additional_probe_index;
+
+    // Guards the indexes and the roll forward caches when probing in parallel.
+    std::mutex m_index_lock;
+    std::mutex m_roll_forward_lock;
+
+    // Indexes of the servicing stores, by probe dir.
+    std::unordered_map<pal::string_t, servicing_index_t> m_servicing_indexes;
+
+    // Hash indexes of the probe dirs that match hashes, by probe dir.
+    std::unordered_map<pal::string_t, std::unique_ptr<hash_index_t>> m_hash_indexes;
+
+    // Probe filters of the package layout probe dirs, by probe dir.
+    std::unordered_map<pal::string_t, std::unique_ptr<probe_filter_t>> m_probe_filters;
+
     std::unordered_map<pal::string_t, pal::string_t> m_patch_roll_forward_cache;
     std::unordered_map<pal::string_t, pal::string_t> m_prerelease_roll_forward_cache;
 
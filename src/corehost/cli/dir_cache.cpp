@@ -0,0 +1,198 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "dir_cache.h"
+#include "trace.h"
+
+namespace
+{
+// File names in a listing compare the way the file system of the platform
+// does. Only Windows volumes are taken to be case insensitive.
+pal::string_t to_listing_key(const pal::string_t& name)
+{
+#if defined(_WIN32)
+    return pal::to_lower(name);
+#else
+    return name;
+#endif
+}
+} // end of anonymous namespace
+
+// File names compare the way the file system of the platform does by default.
+pal::string_t dir_cache_t::to_name_key(const pal::string_t& name)
+{
+#if defined(_WIN32) || defined(__APPLE__)
+    return pal::to_lower(name);
+#else
+    return name;
+#endif
+}
+
+void dir_cache_t::read_listing(const pal::string_t& dir, listing_t* listing)
+{
+    listing->exists = pal::list_dir(dir, &listing->names);
+    sort_listing(listing);
+
+    trace::verbose(_X("Listed directory [%s]: %d entries%s"), dir.c_str(), listing->names.size(), listing->exists ? _X("") : _X(", does not exist"));
+}
+
+void dir_cache_t::add_listing(const pal::string_t& dir, bool exists, const std::vector<pal::string_t>& names)
+{
+    listing_t listing;
+    listing.exists = exists;
+    listing.names = names;
+    sort_listing(&listing);
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_listings[dir] = std::move(listing);
+}
+
+void dir_cache_t::sort_listing(listing_t* listing)
+{
+#if defined(__APPLE__)
+    listing->folded_names.reserve(listing->names.size());
+    for (const auto& name : listing->names)
+    {
+        listing->folded_names.push_back(to_name_key(name));
+    }
+    std::sort(listing->folded_names.begin(), listing->folded_names.end());
+#endif
+    for (auto& name : listing->names)
+    {
+        name = to_listing_key(name);
+    }
+    std::sort(listing->names.begin(), listing->names.end());
+    listing->listed = true;
+}
+
+bool dir_cache_t::file_exists(const pal::string_t& path)
+{
+    auto sep = path.find_last_of(DIR_SEPARATOR);
+    if (sep == pal::string_t::npos || sep == 0 || sep + 1 == path.length())
+    {
+        return pal::file_exists(path);
+    }
+
+    pal::string_t dir = path.substr(0, sep);
+    pal::string_t name = path.substr(sep + 1);
+    lookup_t lookup = lookup_t::unsure;
+    bool list = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        listing_t& listing = m_listings[dir];
+        if (listing.listed)
+        {
+            lookup = find_name(listing, name);
+        }
+        else
+        {
+            auto state = m_file_states.find(path);
+            if (state != m_file_states.end())
+            {
+                return state->second;
+            }
+            if (m_collected != nullptr)
+            {
+                m_collected->push_back(path);
+                return true;
+            }
+            list = (listing.queries++ != 0);
+        }
+    }
+
+    // The lookups of other threads go on while this one reads the file system.
+    return list ? list_and_find(dir, name) : check_name(lookup, dir, name);
+}
+
+void dir_cache_t::set_collector(std::vector<pal::string_t>* collected)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_collected = collected;
+}
+
+void dir_cache_t::add_file_states(const std::vector<pal::string_t>& paths, const std::vector<bool>& exists)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        m_file_states.emplace(paths[i], exists[i]);
+    }
+}
+
+void dir_cache_t::get_dirs(std::vector<pal::string_t>* dirs)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    for (const auto& kv : m_listings)
+    {
+        dirs->push_back(kv.first);
+    }
+}
+
+bool dir_cache_t::contains(const pal::string_t& dir, const pal::string_t& name)
+{
+    lookup_t lookup = lookup_t::unsure;
+    bool listed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        auto iter = m_listings.find(dir);
+        if (iter != m_listings.end() && iter->second.listed)
+        {
+            lookup = find_name(iter->second, name);
+            listed = true;
+        }
+    }
+    return listed ? check_name(lookup, dir, name) : list_and_find(dir, name);
+}
+
+bool dir_cache_t::list_and_find(const pal::string_t& dir, const pal::string_t& name)
+{
+    listing_t listing;
+    read_listing(dir, &listing);
+
+    lookup_t lookup;
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        listing_t& cached = m_listings[dir];
+        if (!cached.listed)
+        {
+            cached = std::move(listing);
+        }
+        lookup = find_name(cached, name);
+    }
+    return check_name(lookup, dir, name);
+}
+
+dir_cache_t::lookup_t dir_cache_t::find_name(const listing_t& listing, const pal::string_t& name)
+{
+    if (!listing.exists)
+    {
+        return lookup_t::missing;
+    }
+    if (std::binary_search(listing.names.begin(), listing.names.end(), to_listing_key(name)))
+    {
+        return lookup_t::found;
+    }
+#if defined(__APPLE__)
+    if (std::binary_search(listing.folded_names.begin(), listing.folded_names.end(), to_name_key(name)))
+    {
+        return lookup_t::unsure;
+    }
+#endif
+    return lookup_t::missing;
+}
+
+// -----------------------------------------------------------------------------
+// Resolve a lookup that the listing could not answer with the file system.
+//
+bool dir_cache_t::check_name(lookup_t lookup, const pal::string_t& dir, const pal::string_t& name)
+{
+    if (lookup != lookup_t::unsure)
+    {
+        return lookup == lookup_t::found;
+    }
+
+    pal::string_t path = dir;
+    path.push_back(DIR_SEPARATOR);
+    path.append(name);
+    return pal::file_exists(path);
+}
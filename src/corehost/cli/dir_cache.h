@@ -0,0 +1,95 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __DIR_CACHE_H_
+#define __DIR_CACHE_H_
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include "pal.h"
+
+// Answers whether files exist from a listing of their directory, read once
+// per directory. Probing a package directory for many assets then costs one
+// directory read instead of one stat per candidate path. A directory is only
+// listed when it is queried a second time, since a single stat is cheaper than
+// reading a directory that is only queried once.
+//
+// The listings are not refreshed, so a cache must not outlive the resolution
+// it is used for. A cache can be shared by threads; it does not hold its lock
+// while it reads the file system.
+//
+// Volumes on macOS can be case sensitive or not, so a name there is looked up
+// exactly, and one that only matches with its case folded is checked with the
+// file system.
+class dir_cache_t
+{
+public:
+    dir_cache_t()
+        : m_collected(nullptr)
+    {
+    }
+
+    // Whether "path" names an existing file or directory.
+    bool file_exists(const pal::string_t& path);
+
+    // Whether the directory "dir" exists and has an entry named "name". Unlike
+    // file_exists, this lists "dir" on the first query.
+    bool contains(const pal::string_t& dir, const pal::string_t& name);
+
+    // Use "names" as the listing of "dir", read elsewhere.
+    void add_listing(const pal::string_t& dir, bool exists, const std::vector<pal::string_t>& names);
+
+    // Collect the paths queried with file_exists that would be read from the
+    // file system, instead of reading them, until called with nullptr. The
+    // paths are answered as existing meanwhile.
+    void set_collector(std::vector<pal::string_t>* collected);
+    bool is_collecting() const { return m_collected != nullptr; }
+
+    // Use "exists" as whether the files "paths" exist, queried elsewhere.
+    void add_file_states(const std::vector<pal::string_t>& paths, const std::vector<bool>& exists);
+
+    // The directories queried so far.
+    void get_dirs(std::vector<pal::string_t>* dirs);
+
+    // The key of "name" in indexes of file names, which may match names that
+    // differ in case on volumes that are case sensitive.
+    static pal::string_t to_name_key(const pal::string_t& name);
+
+private:
+    enum lookup_t
+    {
+        missing,
+        found,
+        unsure // Only the folded name matches.
+    };
+
+    struct listing_t
+    {
+        size_t queries;
+        bool listed;
+        bool exists;
+        std::vector<pal::string_t> names; // Sorted.
+        std::vector<pal::string_t> folded_names; // Sorted, on macOS only.
+
+        listing_t()
+            : queries(0)
+            , listed(false)
+            , exists(false)
+        {
+        }
+    };
+
+    void read_listing(const pal::string_t& dir, listing_t* listing);
+    void sort_listing(listing_t* listing);
+    bool list_and_find(const pal::string_t& dir, const pal::string_t& name);
+    static lookup_t find_name(const listing_t& listing, const pal::string_t& name);
+    static bool check_name(lookup_t lookup, const pal::string_t& dir, const pal::string_t& name);
+
+    std::mutex m_lock;
+    std::unordered_map<pal::string_t, listing_t> m_listings;
+    std::unordered_map<pal::string_t, bool> m_file_states;
+    std::vector<pal::string_t>* m_collected;
+};
+
+#endif // __DIR_CACHE_H_
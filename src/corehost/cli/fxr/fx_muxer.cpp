@@ -15,6 +15,7 @@
 #include "cpprest/json.h"
 #include "error_codes.h"
 #include "deps_format.h"
+#include "json_scanner.h"
 
 
 static const pal::char_t* s_dotnet_sdk_download_url = _X("http://go.microsoft.com/fwlink/?LinkID=798306&clcid=0x409");
@@ -57,8 +58,9 @@ void handle_missing_framework_error(const pal::string_t& fx_name, const pal::str
 /**
  * Resolve the hostpolicy version from deps.
  *  - Scan the deps file's libraries section and find the hostpolicy version in the file.
+ *  - The contents of the deps file are returned in "deps_data" to be handed to hostpolicy.
  */
-pal::string_t resolve_hostpolicy_version_from_deps(const pal::string_t& deps_json)
+pal::string_t resolve_hostpolicy_version_from_deps(const pal::string_t& deps_json, std::string* deps_data)
 {
     trace::verbose(_X("--- Resolving %s version from deps json [%s]"), LIBHOSTPOLICY_NAME, deps_json.c_str());
 
@@ -81,31 +83,38 @@ pal::string_t resolve_hostpolicy_version_from_deps(const pal::string_t& deps_jso
         trace::verbose(_X("UTF-8 BOM skipped while reading [%s]"), deps_json.c_str());
     }
 
-    try
-    {
-        const auto root = json_value::parse(file);
-        const auto& json = root.as_object();
-        const auto& libraries = json.at(_X("libraries")).as_object();
+    deps_data->assign(pal::istreambuf_iterator_t(file), pal::istreambuf_iterator_t());
 
+    // Scan the top level members at byte level for the libraries section and walk
+    // its keys without building a DOM. A deps file lists a package once, so the
+    // scan can stop at the first library that matches.
+    json_scanner::range_t document(deps_data->data(), deps_data->data() + deps_data->size());
+    json_scanner::range_t libraries;
+    if (!json_scanner::find_member(document, "libraries", &libraries))
+    {
+        trace::error(_X("The dependency manifest [%s] is not a well formed JSON object with a libraries section"), deps_json.c_str());
+    }
+    else
+    {
         // Walk through the libraries section and check any library that starts with:
         // "runtime.win7-x64.Microsoft.NETCore.DotNetHostPolicy/" followed by version.
         pal::string_t prefix = _STRINGIFY(HOST_POLICY_PKG_NAME) + pal::string_t(_X("/"));
-        for (const auto& library : libraries)
-        {
-            if (starts_with(library.first, prefix, false))
+        pal::string_t library;
+        bool scanned = json_scanner::for_each_member(libraries, [&](const std::string& key, const json_scanner::range_t&) -> bool {
+            if (pal::utf8_palstring(key, &library) && starts_with(library, prefix, false))
             {
                 // Extract the version information that occurs after '/'
-                retval = library.first.substr(prefix.size());
-                break;
+                retval = library.substr(prefix.size());
+                return false;
             }
+            return true;
+        });
+        if (!scanned)
+        {
+            trace::error(_X("The libraries section of the dependency manifest [%s] is not a well formed JSON object"), deps_json.c_str());
+            retval.clear();
         }
     }
-    catch (const std::exception& je)
-    {
-        pal::string_t jes;
-        (void)pal::utf8_palstring(je.what(), &jes);
-        trace::error(_X("A JSON parsing exception occurred in [%s]: %s"), deps_json.c_str(), jes.c_str());
-    }
     trace::verbose(_X("Resolved version %s from dependency manifest file [%s]"), retval.c_str(), deps_json.c_str());
     return retval;
 }
@@ -248,13 +257,16 @@ bool fx_muxer_t::resolve_hostpolicy_dir(host_mode_t mode,
     const pal::string_t& specified_fx_version,
     const std::vector<pal::string_t>& probe_realpaths,
     const runtime_config_t& config,
-    pal::string_t* impl_dir)
+    pal::string_t* impl_dir,
+    pal::string_t* deps_data_file,
+    std::string* deps_data)
 {
     // Obtain deps file for the given configuration.
     pal::string_t resolved_deps = get_deps_file(fx_dir, app_candidate, specified_deps_file, config);
 
     // Resolve hostpolicy version out of the deps file.
-    pal::string_t version = resolve_hostpolicy_version_from_deps(resolved_deps);
+    pal::string_t version = resolve_hostpolicy_version_from_deps(resolved_deps, deps_data);
+    deps_data_file->assign(resolved_deps);
     if (trace::is_enabled() && version.empty() && pal::file_exists(resolved_deps))
     {
         trace::warning(_X("Dependency manifest %s does not contain an entry for %s"), resolved_deps.c_str(), _STRINGIFY(HOST_POLICY_PKG_NAME));
@@ -752,12 +764,18 @@ int fx_muxer_t::read_config_and_execute(
         (is_portable ? _X("portable") : _X("standalone")), config_file.c_str());
 
     pal::string_t impl_dir;
-    if (!resolve_hostpolicy_dir(mode, own_dir, fx_dir, app_candidate, deps_file, fx_version, probe_realpaths, config, &impl_dir))
+    pal::string_t deps_data_file;
+    std::string deps_data;
+    if (!resolve_hostpolicy_dir(mode, own_dir, fx_dir, app_candidate, deps_file, fx_version, probe_realpaths, config, &impl_dir, &deps_data_file, &deps_data))
     {
         return CoreHostLibMissingFailure;
     }
 
     corehost_init_t init(deps_file, probe_realpaths, fx_dir, mode, config);
+    if (!deps_data.empty())
+    {
+        init.set_deps_data(deps_data_file, &deps_data);
+    }
     return execute_app(impl_dir, &init, new_argc, new_argv);
 }
 
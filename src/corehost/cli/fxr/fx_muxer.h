@@ -32,7 +32,9 @@ private:
         const pal::string_t& specified_fx_version,
         const std::vector<pal::string_t>& probe_realpaths,
         const runtime_config_t& config,
-        pal::string_t* impl_dir);
+        pal::string_t* impl_dir,
+        pal::string_t* deps_data_file,
+        std::string* deps_data);
     static pal::string_t resolve_fx_dir(host_mode_t mode, const pal::string_t& own_dir, const runtime_config_t& config, const pal::string_t& specified_fx_version);
     static pal::string_t resolve_cli_version(const pal::string_t& global);
     static bool resolve_sdk_dotnet_path(const pal::string_t& own_dir, pal::string_t* cli_sdk);
@@ -0,0 +1,318 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "hash_index.h"
+#include "binary_io.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+const uint32_t s_index_magic = 0x58444948; // "HIDX"
+const uint32_t s_index_version = 1;
+
+// The size of the header and the offset of the root stamp in it.
+const size_t s_header_size = 32;
+const size_t s_stamp_offset = 16;
+
+struct hash_record_t
+{
+    pal::string_t name;
+    pal::string_t version;
+    pal::string_t hash;
+};
+
+// Records are ordered by the bytes of their name and version, which is cheap
+// to compare in place and the same for the builder and the reader.
+int compare_bytes(const char* a, size_t a_size, const char* b, size_t b_size)
+{
+    int result = memcmp(a, b, std::min(a_size, b_size));
+    if (result != 0)
+    {
+        return result;
+    }
+    return (a_size < b_size) ? -1 : (a_size > b_size) ? 1 : 0;
+}
+
+int compare_string(const char* bytes, size_t size, const pal::string_t& value)
+{
+    return compare_bytes(bytes, size, reinterpret_cast<const char*>(value.data()), value.size() * sizeof(pal::char_t));
+}
+
+bool record_less(const hash_record_t& a, const hash_record_t& b)
+{
+    int result = compare_string(reinterpret_cast<const char*>(a.name.data()), a.name.size() * sizeof(pal::char_t), b.name);
+    if (result == 0)
+    {
+        result = compare_string(reinterpret_cast<const char*>(a.version.data()), a.version.size() * sizeof(pal::char_t), b.version);
+    }
+    return result < 0;
+}
+
+// -----------------------------------------------------------------------------
+// Read the hash files of a package version directory, named
+// "<name>.<version>.nupkg.<algorithm>", into records.
+//
+void read_hash_files(const pal::string_t& dir, const pal::string_t& name, const pal::string_t& version, std::vector<hash_record_t>* records)
+{
+    std::vector<pal::string_t> files;
+    if (!pal::list_dir(dir, &files))
+    {
+        return;
+    }
+
+    pal::string_t prefix = name + _X(".") + version + _X(".nupkg.");
+    for (const auto& file : files)
+    {
+        if (file.length() <= prefix.length() || file.compare(0, prefix.length(), prefix) != 0)
+        {
+            continue;
+        }
+
+        pal::string_t hash_file = dir;
+        append_path(&hash_file, file.c_str());
+        pal::ifstream_t fstream(hash_file);
+        if (!fstream.good())
+        {
+            continue;
+        }
+
+        std::string hash;
+        hash.assign(pal::istreambuf_iterator_t(fstream), pal::istreambuf_iterator_t());
+        pal::string_t pal_hash;
+        if (!pal::utf8_palstring(hash, &pal_hash))
+        {
+            continue;
+        }
+
+        hash_record_t record;
+        record.name = name;
+        record.version = version;
+        record.hash = file.substr(prefix.length()) + _X("-") + pal_hash;
+        records->push_back(record);
+    }
+}
+} // end of anonymous namespace
+
+hash_index_t::hash_index_t()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_count(0)
+    , m_offsets(nullptr)
+{
+}
+
+hash_index_t::~hash_index_t()
+{
+    if (m_data != nullptr)
+    {
+        pal::unmap_file(m_data, m_size);
+    }
+}
+
+pal::string_t hash_index_t::get_index_file(const pal::string_t& root)
+{
+    pal::string_t index_file = root;
+    append_path(&index_file, _X(".hostindex"));
+    return index_file;
+}
+
+bool hash_index_t::open(const pal::string_t& root)
+{
+    assert(m_data == nullptr);
+
+    pal::string_t index_file = get_index_file(root);
+    const char* data;
+    size_t size;
+    if (!pal::map_file(index_file, &data, &size))
+    {
+        return false;
+    }
+
+    binary_reader_t reader(data, data + size);
+    uint32_t magic, version, char_size, count;
+    uint64_t root_size, root_mtime;
+    bool valid = reader.read_u32(&magic) && magic == s_index_magic &&
+        reader.read_u32(&version) && version == s_index_version &&
+        reader.read_u32(&char_size) && char_size == sizeof(pal::char_t) &&
+        reader.read_u32(&count) &&
+        reader.read_u64(&root_size) && reader.read_u64(&root_mtime) &&
+        (size - s_header_size) / sizeof(uint32_t) >= count;
+    if (!valid)
+    {
+        trace::verbose(_X("Ignoring the hash index [%s] as it could not be read"), index_file.c_str());
+        pal::unmap_file(data, size);
+        return false;
+    }
+
+    pal::file_stamp_t stamp;
+    if (!pal::get_file_stamp(root, &stamp) || stamp.size != root_size || (uint64_t) stamp.mtime != root_mtime)
+    {
+        trace::verbose(_X("Ignoring the hash index [%s] as the cache changed since it was built"), index_file.c_str());
+        pal::unmap_file(data, size);
+        return false;
+    }
+
+    trace::verbose(_X("Using the hash index [%s] of %d package hashes"), index_file.c_str(), count);
+    m_data = data;
+    m_size = size;
+    m_count = count;
+    m_offsets = data + s_header_size;
+    return true;
+}
+
+hash_index_t::match_t hash_index_t::match(const pal::string_t& name, const pal::string_t& version, const pal::string_t& library_hash) const
+{
+    // Read the name, version and hash of the record at "index", in place.
+    struct record_bytes_t
+    {
+        const char* name;
+        size_t name_size;
+        const char* version;
+        size_t version_size;
+        const char* hash;
+        size_t hash_size;
+    };
+    auto read_record = [this](uint32_t index, record_bytes_t* record) -> bool
+    {
+        uint32_t offset;
+        memcpy(&offset, m_offsets + index * sizeof(uint32_t), sizeof(offset));
+        if (offset >= m_size)
+        {
+            return false;
+        }
+        binary_reader_t reader(m_data + offset, m_data + m_size);
+        return reader.read_string_bytes(&record->name, &record->name_size) &&
+            reader.read_string_bytes(&record->version, &record->version_size) &&
+            reader.read_string_bytes(&record->hash, &record->hash_size);
+    };
+    auto compare_key = [&name, &version](const record_bytes_t& record) -> int
+    {
+        int result = compare_string(record.name, record.name_size, name);
+        return (result != 0) ? result : compare_string(record.version, record.version_size, version);
+    };
+
+    // Find the first record of the package version.
+    uint32_t low = 0;
+    uint32_t high = m_count;
+    record_bytes_t record;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (!read_record(mid, &record))
+        {
+            return not_indexed;
+        }
+        if (compare_key(record) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    // A package version has a record per hash algorithm.
+    bool indexed = false;
+    for (uint32_t i = low; i < m_count && read_record(i, &record) && compare_key(record) == 0; ++i)
+    {
+        indexed = true;
+        if (compare_string(record.hash, record.hash_size, library_hash) == 0)
+        {
+            return matched;
+        }
+    }
+    return indexed ? mismatched : not_indexed;
+}
+
+// -----------------------------------------------------------------------------
+// Build the index of the package hashes of the cache at "root".
+//
+// Description:
+//    The index records the stamp of the root directory, so that it is not used
+//    once packages are added to or removed from the cache. The index file is
+//    itself written to the root, so the stamp is only known and patched into
+//    the header after the file is in place.
+//
+bool hash_index_t::build(const pal::string_t& root, size_t* count)
+{
+    std::vector<pal::string_t> names;
+    if (!pal::list_dir(root, &names))
+    {
+        trace::error(_X("The cache directory [%s] could not be read"), root.c_str());
+        return false;
+    }
+
+    std::vector<hash_record_t> records;
+    for (const auto& name : names)
+    {
+        pal::string_t package_dir = root;
+        append_path(&package_dir, name.c_str());
+
+        std::vector<pal::string_t> versions;
+        if (!pal::list_dir(package_dir, &versions))
+        {
+            continue;
+        }
+        for (const auto& version : versions)
+        {
+            pal::string_t version_dir = package_dir;
+            append_path(&version_dir, version.c_str());
+            read_hash_files(version_dir, name, version, &records);
+        }
+    }
+    std::stable_sort(records.begin(), records.end(), record_less);
+
+    std::string bytes;
+    binary_writer_t writer(&bytes);
+    writer.write_u32(s_index_magic);
+    writer.write_u32(s_index_version);
+    writer.write_u32(sizeof(pal::char_t));
+    writer.write_u32((uint32_t) records.size());
+    writer.write_u64(0); // Root stamp, patched below.
+    writer.write_u64(0);
+    assert(bytes.size() == s_header_size);
+
+    std::string record_bytes;
+    binary_writer_t record_writer(&record_bytes);
+    size_t records_offset = s_header_size + records.size() * sizeof(uint32_t);
+    for (const auto& record : records)
+    {
+        writer.write_u32((uint32_t) (records_offset + record_bytes.size()));
+        record_writer.write_string(record.name);
+        record_writer.write_string(record.version);
+        record_writer.write_string(record.hash);
+    }
+    bytes.append(record_bytes);
+
+    pal::string_t index_file = get_index_file(root);
+    if (!write_file_atomically(index_file, bytes))
+    {
+        trace::error(_X("Could not write the hash index [%s]"), index_file.c_str());
+        return false;
+    }
+
+    pal::file_stamp_t stamp;
+    if (!pal::get_file_stamp(root, &stamp))
+    {
+        return false;
+    }
+    std::string stamp_bytes;
+    binary_writer_t stamp_writer(&stamp_bytes);
+    stamp_writer.write_u64(stamp.size);
+    stamp_writer.write_u64((uint64_t) stamp.mtime);
+
+    pal::ofstream_t file(index_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(s_stamp_offset);
+    file.write(stamp_bytes.data(), stamp_bytes.size());
+    file.close();
+    if (file.fail())
+    {
+        trace::error(_X("Could not write the hash index [%s]"), index_file.c_str());
+        return false;
+    }
+
+    *count = records.size();
+    return true;
+}
@@ -0,0 +1,50 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __HASH_INDEX_H_
+#define __HASH_INDEX_H_
+
+#include "pal.h"
+
+// The package hashes of a hosting optimization cache, read from a single index
+// file at the cache root instead of one ".nupkg.<algorithm>" file per package.
+//
+// The index is mapped into memory and searched in place. It is only used if
+// the cache root did not change since the index was built; a package version
+// that is not in the index is looked up in its hash file as before.
+class hash_index_t
+{
+public:
+    enum match_t
+    {
+        not_indexed,
+        matched,
+        mismatched
+    };
+
+    hash_index_t();
+    ~hash_index_t();
+
+    // Map the index of the cache at "root" if there is a current one.
+    bool open(const pal::string_t& root);
+
+    // Whether the package version is indexed with the hash "library_hash",
+    // given as "<algorithm>-<hash>" like in the deps file.
+    match_t match(const pal::string_t& name, const pal::string_t& version, const pal::string_t& library_hash) const;
+
+    // Write the index of the hash files of the packages under "root".
+    static bool build(const pal::string_t& root, size_t* count);
+
+    static pal::string_t get_index_file(const pal::string_t& root);
+
+private:
+    hash_index_t(const hash_index_t&);
+    hash_index_t& operator=(const hash_index_t&);
+
+    const char* m_data;
+    size_t m_size;
+    uint32_t m_count;
+    const char* m_offsets;
+};
+
+#endif // __HASH_INDEX_H_
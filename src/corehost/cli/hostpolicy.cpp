@@ -4,7 +4,7 @@
 #include "pal.h"
 #include "args.h"
 #include "trace.h"
-#include "deps_resolver.h"
+#include "launch_manifest.h"
 #include "fx_muxer.h"
 #include "utils.h"
 #include "coreclr.h"
@@ -12,48 +12,55 @@
 #include "libhost.h"
 #include "error_codes.h"
 #include "breadcrumbs.h"
+#include "probe_filter.h"
+#include "resolve_report.h"
 
 hostpolicy_init_t g_init;
 
 int run(const arguments_t& args)
 {
-    // Load the deps resolver
-    deps_resolver_t resolver(g_init, args);
-
-    pal::string_t resolver_errors;
-    if (!resolver.valid(&resolver_errors))
+    // Use the launch manifest written ahead of time or the snapshot of an
+    // earlier launch, if one is still current; resolve the assets of the app
+    // otherwise, and snapshot them for the next launch. When a resolution
+    // report is asked for, the assets are always resolved, to report on.
+    launch_manifest_t manifest;
+    pal::string_t snapshot_file, report_file;
+    bool has_report = resolve_report_t::get_report_file(&report_file);
+    bool has_snapshot = launch_manifest::get_snapshot_file(args, &snapshot_file);
+    if (has_report)
     {
-        trace::error(_X("Error initializing the dependency resolver: %s"), resolver_errors.c_str());
-        return StatusCode::ResolverInitFailure;
+        trace::info(_X("Resolving the assets for the report [%s], without the launch manifest or snapshot"), report_file.c_str());
     }
-
-    pal::string_t clr_path = resolver.resolve_coreclr_dir();
-    if (clr_path.empty() || !pal::realpath(&clr_path))
+    if (!has_report && launch_manifest::read(launch_manifest::get_manifest_file(args), &manifest) &&
+        launch_manifest::is_current(manifest, g_init, args))
     {
-        trace::error(_X("Could not resolve CoreCLR path. For more details, enable tracing by setting COREHOST_TRACE environment variable to 1"));;
-        return StatusCode::CoreClrResolveFailure;
+        trace::info(_X("Using the launch manifest, CoreCLR directory: %s"), manifest.clr_dir.c_str());
     }
-    else
+    else if (!has_report && has_snapshot && launch_manifest::read(snapshot_file, &manifest) &&
+        launch_manifest::is_current(manifest, g_init, args))
     {
-        trace::info(_X("CoreCLR directory: %s"), clr_path.c_str());
+        trace::info(_X("Using the launch snapshot, CoreCLR directory: %s"), manifest.clr_dir.c_str());
     }
-
-
-    // Setup breadcrumbs
-    pal::string_t policy_name = _STRINGIFY(HOST_POLICY_PKG_NAME);
-    pal::string_t policy_version = _STRINGIFY(HOST_POLICY_PKG_VER);
-
-    // Always insert the hostpolicy that the code is running on.
-    std::unordered_set<pal::string_t> breadcrumbs;
-    breadcrumbs.insert(policy_name);
-    breadcrumbs.insert(policy_name + _X(",") + policy_version);
-
-    probe_paths_t probe_paths;
-    if (!resolver.resolve_probe_paths(clr_path, &probe_paths, &breadcrumbs))
+    else
     {
-        return StatusCode::ResolverResolveFailure;
+        int64_t start_time = 0;
+        bool snapshot = has_snapshot && launch_manifest::begin_snapshot(snapshot_file, &start_time);
+
+        manifest = launch_manifest_t();
+        int code = launch_manifest::resolve(g_init, args, snapshot, &manifest);
+        if (code != StatusCode::Success)
+        {
+            return code;
+        }
+        if (snapshot)
+        {
+            launch_manifest::write_snapshot(snapshot_file, start_time, manifest);
+        }
     }
 
+    const pal::string_t& clr_path = manifest.clr_dir;
+    std::unordered_set<pal::string_t> breadcrumbs(manifest.breadcrumbs.begin(), manifest.breadcrumbs.end());
+
     // Build CoreCLR properties
     std::vector<const char*> property_keys = {
         "TRUSTED_PLATFORM_ASSEMBLIES",
@@ -68,34 +75,31 @@ int run(const arguments_t& args)
         "FX_DEPS_FILE"
     };
 
-    std::vector<char> tpa_paths_cstr, app_base_cstr, native_dirs_cstr, resources_dirs_cstr, fx_deps, deps;
-    pal::pal_clrstring(probe_paths.tpa, &tpa_paths_cstr);
-    pal::pal_clrstring(args.app_dir, &app_base_cstr);
-    pal::pal_clrstring(probe_paths.native, &native_dirs_cstr);
-    pal::pal_clrstring(probe_paths.resources, &resources_dirs_cstr);
-
-    pal::pal_clrstring(resolver.get_fx_deps_file(), &fx_deps);
-    pal::pal_clrstring(resolver.get_deps_file() + _X(";") + resolver.get_fx_deps_file(), &deps);
+    // Where pal strings are already in the encoding CoreCLR takes, the path
+    // lists are passed without copying them.
+    std::vector<char> tpa_paths_cstr, app_base_cstr, native_dirs_cstr, resources_dirs_cstr, fx_deps_cstr, deps_cstr;
+    pal::string_t deps = manifest.deps_file + _X(";") + manifest.fx_deps_file;
+    const char* app_base = pal::pal_clrcstr(args.app_dir, &app_base_cstr);
 
     std::vector<const char*> property_values = {
         // TRUSTED_PLATFORM_ASSEMBLIES
-        tpa_paths_cstr.data(),
+        pal::pal_clrcstr(manifest.tpa, &tpa_paths_cstr),
         // APP_PATHS
-        app_base_cstr.data(),
+        app_base,
         // APP_NI_PATHS
-        app_base_cstr.data(),
+        app_base,
         // NATIVE_DLL_SEARCH_DIRECTORIES
-        native_dirs_cstr.data(),
+        pal::pal_clrcstr(manifest.native, &native_dirs_cstr),
         // PLATFORM_RESOURCE_ROOTS
-        resources_dirs_cstr.data(),
+        pal::pal_clrcstr(manifest.resources, &resources_dirs_cstr),
         // AppDomainCompatSwitch
         "UseLatestBehaviorWhenTFMNotSpecified",
         // APP_CONTEXT_BASE_DIRECTORY
-        app_base_cstr.data(),
+        app_base,
         // APP_CONTEXT_DEPS_FILES,
-        deps.data(),
+        pal::pal_clrcstr(deps, &deps_cstr),
         // FX_DEPS_FILE
-        fx_deps.data()
+        pal::pal_clrcstr(manifest.fx_deps_file, &fx_deps_cstr)
     };
 
     for (int i = 0; i < g_init.cfg_keys.size(); ++i)
@@ -108,7 +112,7 @@ int run(const arguments_t& args)
     assert(property_keys.size() == property_values.size());
 
     // Add API sets to the process DLL search
-    pal::setup_api_sets(resolver.get_api_sets());
+    pal::setup_api_sets(std::unordered_set<pal::string_t>(manifest.api_sets.begin(), manifest.api_sets.end()));
 
     // Bind CoreCLR
     if (!coreclr::bind(clr_path))
@@ -272,5 +276,6 @@ SHARED_API int corehost_main(const int argc, const pal::char_t* argv[])
 
 SHARED_API int corehost_unload()
 {
+    probe_filter_t::stop_builds();
     return 0;
 }
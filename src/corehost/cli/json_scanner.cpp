@@ -0,0 +1,349 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <cassert>
+#include <cstring>
+#include "json_scanner.h"
+
+namespace
+{
+bool is_whitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+const char* skip_whitespace(const char* pos, const char* end)
+{
+    while (pos < end && is_whitespace(*pos))
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+// -----------------------------------------------------------------------------
+// Skip the string that starts with the quote at "pos".
+//
+// Returns:
+//    The position past the closing quote or nullptr if the string does not end.
+//
+const char* skip_string(const char* pos, const char* end)
+{
+    assert(pos < end && *pos == '"');
+    ++pos;
+    while (pos < end)
+    {
+        const char* quote = static_cast<const char*>(memchr(pos, '"', end - pos));
+        if (quote == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The quote is escaped if it is preceded by an odd number of backslashes.
+        const char* slash = quote;
+        while (slash > pos && *(slash - 1) == '\\')
+        {
+            --slash;
+        }
+        if (((quote - slash) % 2) == 0)
+        {
+            return quote + 1;
+        }
+        pos = quote + 1;
+    }
+    return nullptr;
+}
+
+// -----------------------------------------------------------------------------
+// Skip the value that starts at "pos".
+//
+// Returns:
+//    The position past the value or nullptr if the value does not end.
+//
+const char* skip_value(const char* pos, const char* end)
+{
+    if (pos >= end)
+    {
+        return nullptr;
+    }
+
+    if (*pos == '"')
+    {
+        return skip_string(pos, end);
+    }
+
+    if (*pos == '{' || *pos == '[')
+    {
+        int depth = 0;
+        while (pos < end)
+        {
+            switch (*pos)
+            {
+            case '"':
+                pos = skip_string(pos, end);
+                if (pos == nullptr)
+                {
+                    return nullptr;
+                }
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0)
+                {
+                    return pos + 1;
+                }
+                break;
+            }
+            ++pos;
+        }
+        return nullptr;
+    }
+
+    // Numbers, true, false and null run up to the next delimiter.
+    const char* start = pos;
+    while (pos < end && !is_whitespace(*pos) && *pos != ',' && *pos != '}' && *pos != ']')
+    {
+        ++pos;
+    }
+    return (pos == start) ? nullptr : pos;
+}
+
+bool read_hex4(const char* pos, const char* end, unsigned int* value)
+{
+    if (end - pos < 4)
+    {
+        return false;
+    }
+
+    *value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        char c = pos[i];
+        unsigned int digit;
+        if (c >= '0' && c <= '9')
+        {
+            digit = c - '0';
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            digit = c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            digit = c - 'A' + 10;
+        }
+        else
+        {
+            return false;
+        }
+        *value = (*value << 4) | digit;
+    }
+    return true;
+}
+
+void append_utf8(unsigned int code_point, std::string* out)
+{
+    if (code_point < 0x80)
+    {
+        out->push_back(static_cast<char>(code_point));
+    }
+    else if (code_point < 0x800)
+    {
+        out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    else if (code_point < 0x10000)
+    {
+        out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    else
+    {
+        out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+} // end of anonymous namespace
+
+json_scanner::range_t json_scanner::trim(const range_t& range)
+{
+    const char* begin = skip_whitespace(range.begin, range.end);
+    const char* end = range.end;
+    while (end > begin && is_whitespace(*(end - 1)))
+    {
+        --end;
+    }
+    return range_t(begin, end);
+}
+
+bool json_scanner::for_each_member(const range_t& object, const member_visitor_t& visitor)
+{
+    range_t trimmed = trim(object);
+    const char* pos = trimmed.begin;
+    const char* end = trimmed.end;
+
+    if (pos == end || *pos != '{')
+    {
+        return false;
+    }
+
+    pos = skip_whitespace(pos + 1, end);
+    if (pos < end && *pos == '}')
+    {
+        return true;
+    }
+
+    std::string key;
+    while (pos < end)
+    {
+        if (*pos != '"')
+        {
+            return false;
+        }
+
+        const char* key_end = skip_string(pos, end);
+        if (key_end == nullptr || !read_string(range_t(pos, key_end), &key))
+        {
+            return false;
+        }
+
+        pos = skip_whitespace(key_end, end);
+        if (pos == end || *pos != ':')
+        {
+            return false;
+        }
+
+        pos = skip_whitespace(pos + 1, end);
+        const char* value_end = skip_value(pos, end);
+        if (value_end == nullptr)
+        {
+            return false;
+        }
+
+        if (!visitor(key, range_t(pos, value_end)))
+        {
+            return true;
+        }
+
+        pos = skip_whitespace(value_end, end);
+        if (pos == end)
+        {
+            return false;
+        }
+        if (*pos == '}')
+        {
+            return true;
+        }
+        if (*pos != ',')
+        {
+            return false;
+        }
+        pos = skip_whitespace(pos + 1, end);
+    }
+    return false;
+}
+
+bool json_scanner::find_member(const range_t& object, const std::string& key, range_t* value)
+{
+    bool found = false;
+    bool valid = for_each_member(object, [&](const std::string& member, const range_t& member_value) -> bool {
+        if (member == key)
+        {
+            *value = member_value;
+            found = true;
+        }
+        return !found;
+    });
+    return valid && found;
+}
+
+bool json_scanner::read_string(const range_t& value, std::string* out)
+{
+    out->clear();
+
+    if (value.size() < 2 || *value.begin != '"' || *(value.end - 1) != '"')
+    {
+        return false;
+    }
+
+    const char* pos = value.begin + 1;
+    const char* end = value.end - 1;
+
+    // Most keys have no escapes; take them as is.
+    if (memchr(pos, '\\', end - pos) == nullptr)
+    {
+        out->assign(pos, end);
+        return true;
+    }
+
+    out->reserve(end - pos);
+    while (pos < end)
+    {
+        if (*pos != '\\')
+        {
+            out->push_back(*pos++);
+            continue;
+        }
+
+        if (++pos == end)
+        {
+            return false;
+        }
+
+        char escaped = *pos++;
+        switch (escaped)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out->push_back(escaped);
+            break;
+        case 'b':
+            out->push_back('\b');
+            break;
+        case 'f':
+            out->push_back('\f');
+            break;
+        case 'n':
+            out->push_back('\n');
+            break;
+        case 'r':
+            out->push_back('\r');
+            break;
+        case 't':
+            out->push_back('\t');
+            break;
+        case 'u':
+            {
+                unsigned int code_point;
+                if (!read_hex4(pos, end, &code_point))
+                {
+                    return false;
+                }
+                pos += 4;
+
+                // Combine a surrogate pair into a single code point.
+                unsigned int low;
+                if (code_point >= 0xD800 && code_point <= 0xDBFF &&
+                    end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u' &&
+                    read_hex4(pos + 2, end, &low) && low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    pos += 6;
+                }
+                append_utf8(code_point, out);
+            }
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __JSON_SCANNER_H_
+#define __JSON_SCANNER_H_
+
+#include <string>
+#include <streambuf>
+#include <functional>
+
+// A forward-only scanner over the UTF-8 bytes of a JSON document. It does not
+// build a DOM; it only locates the byte ranges of values, so callers can hand
+// the subtrees they need to the JSON parser and skip the rest at byte level.
+//
+// The scanner checks that strings and brackets are balanced but otherwise
+// does not validate the values it skips.
+namespace json_scanner
+{
+    // A JSON value as the range [begin, end) of the document bytes.
+    struct range_t
+    {
+        const char* begin;
+        const char* end;
+
+        range_t()
+            : begin(nullptr)
+            , end(nullptr)
+        {
+        }
+
+        range_t(const char* begin, const char* end)
+            : begin(begin)
+            , end(end)
+        {
+        }
+
+        bool empty() const
+        {
+            return begin == end;
+        }
+
+        size_t size() const
+        {
+            return end - begin;
+        }
+    };
+
+    typedef std::function<bool(const std::string& key, const range_t& value)> member_visitor_t;
+
+    // Trim the whitespace around the value in "range".
+    range_t trim(const range_t& range);
+
+    // Visit the members of the JSON object in "object" in document order. The
+    // visitor returns false to stop the walk. Returns false if "object" is not
+    // a well formed object.
+    bool for_each_member(const range_t& object, const member_visitor_t& visitor);
+
+    // Locate the value of the first member named "key" in "object".
+    bool find_member(const range_t& object, const std::string& key, range_t* value);
+
+    // Decode the JSON string in "value" into its UTF-8 contents.
+    bool read_string(const range_t& value, std::string* out);
+
+    // A read-only stream buffer over a range, to parse a range without copying it.
+    class range_streambuf_t : public std::streambuf
+    {
+    public:
+        explicit range_streambuf_t(const range_t& range)
+        {
+            char* begin = const_cast<char*>(range.begin);
+            char* end = const_cast<char*>(range.end);
+            setg(begin, begin, end);
+        }
+    };
+};
+
+#endif // __JSON_SCANNER_H_
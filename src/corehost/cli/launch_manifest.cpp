@@ -0,0 +1,449 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <algorithm>
+
+#include "launch_manifest.h"
+#include "binary_io.h"
+#include "deps_cache.h"
+#include "deps_resolver.h"
+#include "error_codes.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+const uint32_t s_manifest_magic = 0x464E4D48; // "HMNF"
+const uint32_t s_manifest_version = 4;
+
+pal::string_t get_host_version()
+{
+    return pal::string_t(_STRINGIFY(HOST_POLICY_PKG_VER)) + _X(",") + _STRINGIFY(REPO_COMMIT_HASH);
+}
+
+// A stamp records the file id only with "ids". Files are given new ids when
+// an image is extracted again, as on every host that pulls it, which would
+// leave a published manifest never current; a snapshot stays on one host.
+void add_stamps(const std::vector<pal::string_t>& paths, bool ids, launch_manifest_t* manifest)
+{
+    std::vector<pal::file_stamp_t> stamps;
+    std::vector<bool> exists;
+    pal::get_file_stamps(paths, &stamps, &exists);
+
+    manifest->stamps.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        launch_manifest_stamp_t& entry = manifest->stamps[i];
+        entry.path = paths[i];
+        entry.exists = exists[i];
+        entry.stamp = stamps[i];
+        if (!ids)
+        {
+            entry.stamp.id = 0;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Hash the names in the app directory, leaving out the launch manifest and its
+// temporary files. Writing the manifest changes the stamp of the directory it
+// is written to, so the app directory of a manifest is checked by its names.
+//
+uint64_t hash_app_dir(const arguments_t& args)
+{
+    std::vector<pal::string_t> names;
+    if (!pal::list_dir(args.app_dir, &names))
+    {
+        return 0;
+    }
+    std::sort(names.begin(), names.end());
+
+    pal::string_t manifest_name = get_filename(launch_manifest::get_manifest_file(args));
+    pal::string_t listing;
+    for (const auto& name : names)
+    {
+        if (name.compare(0, manifest_name.length(), manifest_name) != 0)
+        {
+            listing.append(name);
+            listing.push_back(_X('\0'));
+        }
+    }
+    return deps_cache::hash(reinterpret_cast<const char*>(listing.data()), listing.size() * sizeof(pal::char_t));
+}
+
+// -----------------------------------------------------------------------------
+// Stamp the deps files, the directories the resolution started from and the
+// directories of the servicing stores, down to their package directories so
+// that a newly serviced package is picked up. The names in the app directory
+// are hashed, so that an assembly added next to the app is picked up too.
+//
+// Otherwise the check is cheap rather than complete: a directory stamp only
+// changes when an entry directly in it is added, removed or renamed, so a
+// change deeper in a probe directory needs the manifest to be written again.
+//
+// With "dependencies", every file and directory the resolution read or looked
+// into is stamped as well, as a snapshot needs. The snapshot is not written
+// to the app directory, which is then stamped rather than hashed.
+//
+void add_stamps(const arguments_t& args, deps_resolver_t* resolver, bool dependencies, launch_manifest_t* manifest)
+{
+    std::vector<pal::string_t> paths;
+    std::unordered_set<pal::string_t> seen;
+    auto add = [&paths, &seen](const pal::string_t& path)
+    {
+        if (!path.empty() && seen.insert(path).second)
+        {
+            paths.push_back(path);
+        }
+    };
+
+    add(manifest->deps_file);
+    add(manifest->fx_deps_file);
+    add(manifest->fx_dir);
+    add(manifest->clr_dir);
+    add(args.core_servicing);
+    add(args.dotnet_packages_cache);
+    for (const auto& probe : args.probe_paths)
+    {
+        add(probe);
+    }
+
+    std::vector<pal::string_t> resolved;
+    resolver->get_servicing_dependencies(&resolved);
+    if (dependencies)
+    {
+        resolver->get_dependencies(&resolved);
+    }
+    for (const auto& path : resolved)
+    {
+        add(path);
+    }
+
+    manifest->app_dir_hash = dependencies ? 0 : hash_app_dir(args);
+    add_stamps(paths, dependencies, manifest);
+}
+
+void write_stamp(binary_writer_t* writer, const launch_manifest_stamp_t& entry)
+{
+    writer->write_string(entry.path);
+    writer->write_u32(entry.exists ? 1 : 0);
+    writer->write_u64(entry.stamp.size);
+    writer->write_u64((uint64_t) entry.stamp.mtime);
+    writer->write_u64(entry.stamp.id);
+}
+
+bool read_stamp(binary_reader_t* reader, launch_manifest_stamp_t* entry)
+{
+    uint32_t exists;
+    uint64_t mtime;
+    if (!reader->read_string(&entry->path) || !reader->read_u32(&exists) ||
+        !reader->read_u64(&entry->stamp.size) || !reader->read_u64(&mtime) ||
+        !reader->read_u64(&entry->stamp.id))
+    {
+        return false;
+    }
+    entry->exists = (exists != 0);
+    entry->stamp.mtime = (int64_t) mtime;
+    return true;
+}
+
+bool read_manifest(binary_reader_t* reader, launch_manifest_t* manifest)
+{
+    uint32_t magic, version, char_size, is_portable, patch_roll_forward, prerelease_roll_forward, count;
+    if (!reader->read_u32(&magic) || magic != s_manifest_magic ||
+        !reader->read_u32(&version) || version != s_manifest_version ||
+        !reader->read_u32(&char_size) || char_size != sizeof(pal::char_t))
+    {
+        return false;
+    }
+
+    if (!reader->read_string(&manifest->host_version) ||
+        !reader->read_string(&manifest->fx_dir) ||
+        !reader->read_string(&manifest->fx_name) ||
+        !reader->read_u32(&is_portable) ||
+        !reader->read_u32(&patch_roll_forward) ||
+        !reader->read_u32(&prerelease_roll_forward) ||
+        !reader->read_string(&manifest->app_dir) ||
+        !reader->read_string(&manifest->deps_path) ||
+        !reader->read_string(&manifest->core_servicing) ||
+        !reader->read_string(&manifest->packages_cache) ||
+        !reader->read_strings(&manifest->probe_paths))
+    {
+        return false;
+    }
+    manifest->is_portable = (is_portable != 0);
+    manifest->patch_roll_forward = (patch_roll_forward != 0);
+    manifest->prerelease_roll_forward = (prerelease_roll_forward != 0);
+
+    if (!reader->read_count(&count))
+    {
+        return false;
+    }
+    manifest->stamps.resize(count);
+    for (auto& entry : manifest->stamps)
+    {
+        if (!read_stamp(reader, &entry))
+        {
+            return false;
+        }
+    }
+
+    return reader->read_u64(&manifest->app_dir_hash) &&
+        reader->read_string(&manifest->clr_dir) &&
+        reader->read_string(&manifest->tpa) &&
+        reader->read_string(&manifest->native) &&
+        reader->read_string(&manifest->resources) &&
+        reader->read_string(&manifest->deps_file) &&
+        reader->read_string(&manifest->fx_deps_file) &&
+        reader->read_strings(&manifest->breadcrumbs) &&
+        reader->read_strings(&manifest->api_sets) &&
+        reader->at_end();
+}
+} // end of anonymous namespace
+
+int launch_manifest::resolve(const hostpolicy_init_t& init, const arguments_t& args, bool stamp_dependencies, launch_manifest_t* manifest)
+{
+    manifest->host_version = get_host_version();
+    manifest->fx_dir = init.fx_dir;
+    manifest->fx_name = init.fx_name;
+    manifest->is_portable = init.is_portable;
+    manifest->patch_roll_forward = init.patch_roll_forward;
+    manifest->prerelease_roll_forward = init.prerelease_roll_forward;
+    manifest->app_dir = args.app_dir;
+    manifest->deps_path = args.deps_path;
+    manifest->core_servicing = args.core_servicing;
+    manifest->packages_cache = args.dotnet_packages_cache;
+    manifest->probe_paths = args.probe_paths;
+
+    // Load the deps resolver
+    deps_resolver_t resolver(init, args);
+
+    pal::string_t resolver_errors;
+    if (!resolver.valid(&resolver_errors))
+    {
+        trace::error(_X("Error initializing the dependency resolver: %s"), resolver_errors.c_str());
+        return StatusCode::ResolverInitFailure;
+    }
+
+    pal::string_t clr_path = resolver.resolve_coreclr_dir();
+    if (clr_path.empty() || !pal::realpath(&clr_path))
+    {
+        trace::error(_X("Could not resolve CoreCLR path. For more details, enable tracing by setting COREHOST_TRACE environment variable to 1"));;
+        return StatusCode::CoreClrResolveFailure;
+    }
+    else
+    {
+        trace::info(_X("CoreCLR directory: %s"), clr_path.c_str());
+    }
+
+
+    // Setup breadcrumbs
+    pal::string_t policy_name = _STRINGIFY(HOST_POLICY_PKG_NAME);
+    pal::string_t policy_version = _STRINGIFY(HOST_POLICY_PKG_VER);
+
+    // Always insert the hostpolicy that the code is running on.
+    std::unordered_set<pal::string_t> breadcrumbs;
+    breadcrumbs.insert(policy_name);
+    breadcrumbs.insert(policy_name + _X(",") + policy_version);
+
+    probe_paths_t probe_paths;
+    if (!resolver.resolve_probe_paths(clr_path, &probe_paths, &breadcrumbs))
+    {
+        return StatusCode::ResolverResolveFailure;
+    }
+
+    manifest->clr_dir = clr_path;
+    manifest->tpa.swap(probe_paths.tpa);
+    manifest->native.swap(probe_paths.native);
+    manifest->resources.swap(probe_paths.resources);
+    manifest->deps_file = resolver.get_deps_file();
+    manifest->fx_deps_file = resolver.get_fx_deps_file();
+    manifest->breadcrumbs.assign(breadcrumbs.begin(), breadcrumbs.end());
+    manifest->api_sets.assign(resolver.get_api_sets().begin(), resolver.get_api_sets().end());
+
+    add_stamps(args, &resolver, stamp_dependencies, manifest);
+    return StatusCode::Success;
+}
+
+bool launch_manifest::is_current(const launch_manifest_t& manifest, const hostpolicy_init_t& init, const arguments_t& args)
+{
+    if (manifest.host_version != get_host_version() ||
+        manifest.fx_dir != init.fx_dir ||
+        manifest.fx_name != init.fx_name ||
+        manifest.is_portable != init.is_portable ||
+        manifest.patch_roll_forward != init.patch_roll_forward ||
+        manifest.prerelease_roll_forward != init.prerelease_roll_forward ||
+        manifest.app_dir != args.app_dir ||
+        manifest.deps_path != args.deps_path ||
+        manifest.core_servicing != args.core_servicing ||
+        manifest.packages_cache != args.dotnet_packages_cache ||
+        manifest.probe_paths != args.probe_paths)
+    {
+        trace::verbose(_X("The launch manifest was written for a different host, framework or arguments"));
+        return false;
+    }
+
+    std::vector<pal::string_t> paths;
+    paths.reserve(manifest.stamps.size());
+    for (const auto& entry : manifest.stamps)
+    {
+        paths.push_back(entry.path);
+    }
+    std::vector<pal::file_stamp_t> stamps;
+    std::vector<bool> exists;
+    pal::get_file_stamps(paths, &stamps, &exists);
+
+    for (size_t i = 0; i < manifest.stamps.size(); ++i)
+    {
+        const launch_manifest_stamp_t& entry = manifest.stamps[i];
+        const pal::file_stamp_t& stamp = stamps[i];
+        if (exists[i] != entry.exists ||
+            (exists[i] && (stamp.size != entry.stamp.size || stamp.mtime != entry.stamp.mtime ||
+                (entry.stamp.id != 0 && stamp.id != entry.stamp.id))))
+        {
+            trace::verbose(_X("The launch manifest is out of date as [%s] changed"), entry.path.c_str());
+            return false;
+        }
+    }
+
+    if (manifest.app_dir_hash != 0 && manifest.app_dir_hash != hash_app_dir(args))
+    {
+        trace::verbose(_X("The launch manifest is out of date as the files in [%s] changed"), args.app_dir.c_str());
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// The launch manifest of an app sits next to it, as "<app>.hostmanifest".
+//
+pal::string_t launch_manifest::get_manifest_file(const arguments_t& args)
+{
+    return strip_file_ext(args.managed_application) + _X(".hostmanifest");
+}
+
+// -----------------------------------------------------------------------------
+// The snapshot of the resolution of an app is kept in the host cache
+// directory, named after the app and the host.
+//
+bool launch_manifest::get_snapshot_file(const arguments_t& args, pal::string_t* snapshot_file)
+{
+    pal::string_t cache_dir;
+    if (!get_host_cache_dir(&cache_dir))
+    {
+        return false;
+    }
+
+    pal::string_t key = args.managed_application + _X("|") + get_host_version();
+    pal::stringstream_t name;
+    name << std::hex << deps_cache::hash(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(pal::char_t)) << _X(".launch.cache");
+
+    snapshot_file->assign(cache_dir);
+    append_path(snapshot_file, name.str().c_str());
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Empty the snapshot before resolving again, which also reads the time the
+// resolution starts at off the clock of the file system the stamps use.
+//
+bool launch_manifest::begin_snapshot(const pal::string_t& snapshot_file, int64_t* start_time)
+{
+    pal::file_stamp_t stamp;
+    if (!write_file_atomically(snapshot_file, std::string()) || !pal::get_file_stamp(snapshot_file, &stamp))
+    {
+        return false;
+    }
+    *start_time = stamp.mtime;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Write the snapshot, unless one of the files or directories it depends on
+// changed since the resolution started: the resolution may then have seen it
+// before the change and its stamp after.
+//
+bool launch_manifest::write_snapshot(const pal::string_t& snapshot_file, int64_t start_time, const launch_manifest_t& manifest)
+{
+    for (const auto& entry : manifest.stamps)
+    {
+        if (entry.exists && entry.stamp.mtime >= start_time)
+        {
+            trace::verbose(_X("Not writing the launch snapshot [%s] as [%s] changed while resolving"), snapshot_file.c_str(), entry.path.c_str());
+            return false;
+        }
+    }
+    if (!write(snapshot_file, manifest))
+    {
+        return false;
+    }
+    trace::verbose(_X("Wrote the launch snapshot [%s] of %d stamps"), snapshot_file.c_str(), manifest.stamps.size());
+    return true;
+}
+
+bool launch_manifest::read(const pal::string_t& manifest_file, launch_manifest_t* manifest)
+{
+    pal::ifstream_t file(manifest_file, std::ios::binary);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    std::string bytes;
+    bytes.assign(pal::istreambuf_iterator_t(file), pal::istreambuf_iterator_t());
+
+    binary_reader_t reader(bytes.data(), bytes.data() + bytes.size());
+    if (!read_manifest(&reader, manifest))
+    {
+        trace::verbose(_X("Ignoring the launch manifest [%s] as it could not be read"), manifest_file.c_str());
+        *manifest = launch_manifest_t();
+        return false;
+    }
+    trace::verbose(_X("Read the launch manifest [%s]"), manifest_file.c_str());
+    return true;
+}
+
+bool launch_manifest::write(const pal::string_t& manifest_file, const launch_manifest_t& manifest)
+{
+    std::string bytes;
+    binary_writer_t writer(&bytes);
+
+    writer.write_u32(s_manifest_magic);
+    writer.write_u32(s_manifest_version);
+    writer.write_u32(sizeof(pal::char_t));
+
+    writer.write_string(manifest.host_version);
+    writer.write_string(manifest.fx_dir);
+    writer.write_string(manifest.fx_name);
+    writer.write_u32(manifest.is_portable ? 1 : 0);
+    writer.write_u32(manifest.patch_roll_forward ? 1 : 0);
+    writer.write_u32(manifest.prerelease_roll_forward ? 1 : 0);
+    writer.write_string(manifest.app_dir);
+    writer.write_string(manifest.deps_path);
+    writer.write_string(manifest.core_servicing);
+    writer.write_string(manifest.packages_cache);
+    writer.write_strings(manifest.probe_paths);
+
+    writer.write_u32((uint32_t) manifest.stamps.size());
+    for (const auto& entry : manifest.stamps)
+    {
+        write_stamp(&writer, entry);
+    }
+    writer.write_u64(manifest.app_dir_hash);
+
+    writer.write_string(manifest.clr_dir);
+    writer.write_string(manifest.tpa);
+    writer.write_string(manifest.native);
+    writer.write_string(manifest.resources);
+    writer.write_string(manifest.deps_file);
+    writer.write_string(manifest.fx_deps_file);
+    writer.write_strings(manifest.breadcrumbs);
+    writer.write_strings(manifest.api_sets);
+
+    if (!write_file_atomically(manifest_file, bytes))
+    {
+        trace::error(_X("Could not write the launch manifest [%s]"), manifest_file.c_str());
+        return false;
+    }
+    return true;
+}
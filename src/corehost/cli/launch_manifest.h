@@ -0,0 +1,86 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __LAUNCH_MANIFEST_H_
+#define __LAUNCH_MANIFEST_H_
+
+#include <vector>
+#include "pal.h"
+#include "args.h"
+#include "libhost.h"
+
+// A file or directory the resolution read, with its stamp at that time.
+struct launch_manifest_stamp_t
+{
+    pal::string_t path;
+    bool exists;
+    pal::file_stamp_t stamp;
+};
+
+// The result of resolving the assets of an app, which is everything hostpolicy
+// needs to start CoreCLR besides the runtimeconfig properties passed by hostfxr.
+//
+// It can be written ahead of time by the dotnet-host-manifest tool next to the
+// app, so that an app in an immutable layout does not pay for the resolution
+// on every launch. Where there is a host cache directory, hostpolicy keeps a
+// snapshot of it there too, stamped with everything the resolution depends
+// on.
+struct launch_manifest_t
+{
+    // The inputs of the resolution.
+    pal::string_t host_version;
+    pal::string_t fx_dir;
+    pal::string_t fx_name;
+    bool is_portable;
+    bool patch_roll_forward;
+    bool prerelease_roll_forward;
+    pal::string_t app_dir;
+    pal::string_t deps_path;
+    pal::string_t core_servicing;
+    pal::string_t packages_cache;
+    std::vector<pal::string_t> probe_paths;
+    std::vector<launch_manifest_stamp_t> stamps;
+    uint64_t app_dir_hash; // The names in the app directory, or 0 if it is stamped.
+
+    // The outputs of the resolution.
+    pal::string_t clr_dir;
+    pal::string_t tpa;
+    pal::string_t native;
+    pal::string_t resources;
+    pal::string_t deps_file;
+    pal::string_t fx_deps_file;
+    std::vector<pal::string_t> breadcrumbs;
+    std::vector<pal::string_t> api_sets;
+
+    launch_manifest_t()
+        : is_portable(false)
+        , patch_roll_forward(false)
+        , prerelease_roll_forward(false)
+        , app_dir_hash(0)
+    {
+    }
+};
+
+namespace launch_manifest
+{
+    // Resolve the assets of the app; returns a StatusCode. With
+    // "stamp_dependencies", every file and directory the resolution depends
+    // on is stamped, rather than only the ones it started from.
+    int resolve(const hostpolicy_init_t& init, const arguments_t& args, bool stamp_dependencies, launch_manifest_t* manifest);
+
+    // Whether "manifest" was resolved from the same inputs and none of the
+    // files and directories it read changed since.
+    bool is_current(const launch_manifest_t& manifest, const hostpolicy_init_t& init, const arguments_t& args);
+
+    pal::string_t get_manifest_file(const arguments_t& args);
+
+    // Snapshots are manifests that hostpolicy writes itself after resolving
+    // the assets of an app, in the host cache directory, for later launches.
+    bool get_snapshot_file(const arguments_t& args, pal::string_t* snapshot_file);
+    bool begin_snapshot(const pal::string_t& snapshot_file, int64_t* start_time);
+    bool write_snapshot(const pal::string_t& snapshot_file, int64_t start_time, const launch_manifest_t& manifest);
+    bool read(const pal::string_t& manifest_file, launch_manifest_t* manifest);
+    bool write(const pal::string_t& manifest_file, const launch_manifest_t& manifest);
+};
+
+#endif // __LAUNCH_MANIFEST_H_
@@ -43,6 +43,10 @@ struct host_interface_t
     size_t patch_roll_forward;
     size_t prerelease_roll_forward;
     size_t host_mode;
+    size_t deps_data_version;         // HOST_INTERFACE_DEPS_DATA_VERSION if the fields below are set, 0 otherwise.
+    const pal::char_t* deps_data_file;
+    const char* deps_data;            // UTF-8 contents of deps_data_file past the BOM, owned by the caller.
+    size_t deps_data_size;
     // !! WARNING / WARNING / WARNING / WARNING / WARNING / WARNING / WARNING / WARNING / WARNING
     // !! 1. Only append to this structure to maintain compat.
     // !! 2. Any nested structs should not use compiler specific padding (pack with _HOST_INTERFACE_PACK)
@@ -65,11 +69,19 @@ static_assert(offsetof(host_interface_t, probe_paths) == 10 * sizeof(size_t), "S
 static_assert(offsetof(host_interface_t, patch_roll_forward) == 12 * sizeof(size_t), "Struct offset breaks backwards compatibility");
 static_assert(offsetof(host_interface_t, prerelease_roll_forward) == 13 * sizeof(size_t), "Struct offset breaks backwards compatibility");
 static_assert(offsetof(host_interface_t, host_mode) == 14 * sizeof(size_t), "Struct offset breaks backwards compatibility");
-static_assert(sizeof(host_interface_t) == 15 * sizeof(size_t), "Did you add static asserts for the newly added fields?");
+static_assert(offsetof(host_interface_t, deps_data_version) == 15 * sizeof(size_t), "Struct offset breaks backwards compatibility");
+static_assert(offsetof(host_interface_t, deps_data_file) == 16 * sizeof(size_t), "Struct offset breaks backwards compatibility");
+static_assert(offsetof(host_interface_t, deps_data) == 17 * sizeof(size_t), "Struct offset breaks backwards compatibility");
+static_assert(offsetof(host_interface_t, deps_data_size) == 18 * sizeof(size_t), "Struct offset breaks backwards compatibility");
+static_assert(sizeof(host_interface_t) == 19 * sizeof(size_t), "Did you add static asserts for the newly added fields?");
 
 #define HOST_INTERFACE_LAYOUT_VERSION_HI 0x16041101 // YYMMDD:nn always increases when layout breaks compat.
 #define HOST_INTERFACE_LAYOUT_VERSION_LO sizeof(host_interface_t)
 
+// The deps data fields are optional; hosts that do not pass them use the smaller layout.
+#define HOST_INTERFACE_LAYOUT_VERSION_LO_MIN offsetof(host_interface_t, deps_data_version)
+#define HOST_INTERFACE_DEPS_DATA_VERSION 1
+
 class corehost_init_t
 {
 private:
@@ -88,6 +100,8 @@ private:
     host_mode_t m_host_mode;
     host_interface_t m_host_interface;
     const pal::string_t m_fx_ver;
+    pal::string_t m_deps_data_file;
+    std::string m_deps_data;
 public:
     corehost_init_t(
         const pal::string_t& deps_file,
@@ -127,6 +141,14 @@ public:
         return m_fx_ver;
     }
 
+    // Hand the contents of a deps file that was already read to hostpolicy,
+    // so it does not have to read the file again.
+    void set_deps_data(const pal::string_t& deps_file, std::string* deps_data)
+    {
+        m_deps_data_file = deps_file;
+        m_deps_data.swap(*deps_data);
+    }
+
     const host_interface_t& get_host_init_data()
     {
         host_interface_t& hi = m_host_interface;
@@ -151,6 +173,14 @@ public:
         hi.patch_roll_forward = m_patch_roll_forward;
         hi.prerelease_roll_forward = m_prerelease_roll_forward;
         hi.host_mode = m_host_mode;
+
+        if (!m_deps_data_file.empty())
+        {
+            hi.deps_data_version = HOST_INTERFACE_DEPS_DATA_VERSION;
+            hi.deps_data_file = m_deps_data_file.c_str();
+            hi.deps_data = m_deps_data.data();
+            hi.deps_data_size = m_deps_data.size();
+        }
         
         return hi;
     }
@@ -181,6 +211,12 @@ struct hostpolicy_init_t
     bool prerelease_roll_forward;
     bool is_portable;
 
+    // Deps file contents read by hostfxr, if any. The data is owned by hostfxr
+    // and stays valid until corehost_main returns.
+    pal::string_t deps_data_file;
+    const char* deps_data;
+    size_t deps_data_size;
+
     static bool init(host_interface_t* input, hostpolicy_init_t* init)
     {
         // Check if there are any breaking changes.
@@ -190,9 +226,9 @@ struct hostpolicy_init_t
             return false;
         }
         // Check if the size is at least what we expect to contain.
-        if (input->version_lo < HOST_INTERFACE_LAYOUT_VERSION_LO)
+        if (input->version_lo < HOST_INTERFACE_LAYOUT_VERSION_LO_MIN)
         {
-            trace::error(_X("The size of the data layout used to initialize %s is %d; expected at least %d"), LIBHOSTPOLICY_NAME, input->version_lo, HOST_INTERFACE_LAYOUT_VERSION_LO);
+            trace::error(_X("The size of the data layout used to initialize %s is %d; expected at least %d"), LIBHOSTPOLICY_NAME, input->version_lo, HOST_INTERFACE_LAYOUT_VERSION_LO_MIN);
             return false;
         }
         trace::verbose(_X("Reading from host interface version: [0x%04x:%d] to initialize policy version: [0x%04x:%d]"), input->version_hi, input->version_lo, HOST_INTERFACE_LAYOUT_VERSION_HI, HOST_INTERFACE_LAYOUT_VERSION_LO);
@@ -211,10 +247,30 @@ struct hostpolicy_init_t
         init->prerelease_roll_forward = input->prerelease_roll_forward;
         init->host_mode = (host_mode_t) input->host_mode;
 
+        init->deps_data_file.clear();
+        init->deps_data = nullptr;
+        init->deps_data_size = 0;
+        if (input->version_lo >= HOST_INTERFACE_LAYOUT_VERSION_LO)
+        {
+            read_deps_data(input, init);
+        }
+
         return true;
     }
 
 private:
+    static void read_deps_data(const host_interface_t* input, hostpolicy_init_t* init)
+    {
+        if (input->deps_data_version != HOST_INTERFACE_DEPS_DATA_VERSION || input->deps_data_file == nullptr || input->deps_data == nullptr)
+        {
+            trace::verbose(_X("No deps data of version [%d] was passed by the host"), HOST_INTERFACE_DEPS_DATA_VERSION);
+            return;
+        }
+        init->deps_data_file = input->deps_data_file;
+        init->deps_data = input->deps_data;
+        init->deps_data_size = input->deps_data_size;
+    }
+
     static void make_palstr_arr(int argc, const pal::char_t** argv, std::vector<pal::string_t>* out)
     {
         out->reserve(argc);
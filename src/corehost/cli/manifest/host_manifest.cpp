@@ -0,0 +1,216 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "pal.h"
+#include "args.h"
+#include "trace.h"
+#include "utils.h"
+#include "libhost.h"
+#include "runtime_config.h"
+#include "launch_manifest.h"
+#include "hash_index.h"
+#include "probe_filter.h"
+#include "error_codes.h"
+
+// -----------------------------------------------------------------------------
+// dotnet-host-manifest resolves the assets of an app the way hostpolicy would
+// at launch and writes the result next to the app as its launch manifest.
+// Meant to run once when an immutable image of the app is built, on the same
+// layout the app will run from.
+//
+// "dotnet-host-manifest index-cache" writes the hash index of hosting
+// optimization caches, so the host does not read a hash file per package.
+//
+
+int usage()
+{
+    trace::println();
+    trace::println(_X("Microsoft .NET Core Host Launch Manifest Generator"));
+    trace::println();
+    trace::println(_X("  Version  : %s"), _STRINGIFY(HOST_POLICY_PKG_VER));
+    trace::println(_X("  Build    : %s"), _STRINGIFY(REPO_COMMIT_HASH));
+    trace::println();
+    trace::println(_X("Usage: dotnet-host-manifest [options] path-to-application"));
+    trace::println(_X("       dotnet-host-manifest index-cache path-to-cache..."));
+    trace::println();
+    trace::println(_X("Options:"));
+    trace::println(_X("  --fx-dir <path>                  Directory of the Shared Framework the application runs on. Required for portable applications."));
+    trace::println(_X("  --depsfile <path>                Path to the deps.json of the application."));
+    trace::println(_X("  --runtimeconfig <path>           Path to the runtimeconfig.json of the application."));
+    trace::println(_X("  --additionalprobingpath <path>   Path containing probing policy and assemblies to probe for."));
+    trace::println();
+    trace::println(_X("The servicing and packages cache directories are read from the environment, as at launch."));
+    trace::println(_X("Rerun index-cache after packages are added to or removed from a cache."));
+    trace::println();
+    return StatusCode::InvalidArgFailure;
+}
+
+int generate(const int argc, const pal::char_t* argv[])
+{
+    std::vector<pal::string_t> known_opts = {
+        _X("--fx-dir"),
+        _X("--depsfile"),
+        _X("--runtimeconfig"),
+        _X("--additionalprobingpath")
+    };
+
+    int num_parsed = 1;
+    std::unordered_map<pal::string_t, std::vector<pal::string_t>> opts;
+    if (!parse_known_args(argc, argv, known_opts, &opts, &num_parsed) || num_parsed + 1 != argc)
+    {
+        return usage();
+    }
+
+    pal::string_t app = argv[num_parsed];
+    if (!pal::realpath(&app) || !pal::file_exists(app))
+    {
+        trace::error(_X("The application [%s] does not exist"), argv[num_parsed]);
+        return StatusCode::InvalidArgFailure;
+    }
+
+    pal::string_t fx_dir = get_last_known_arg(opts, _X("--fx-dir"), _X(""));
+    pal::string_t deps_file = get_last_known_arg(opts, _X("--depsfile"), _X(""));
+    pal::string_t runtime_config = get_last_known_arg(opts, _X("--runtimeconfig"), _X(""));
+    std::vector<pal::string_t> spec_probe_paths = opts.count(_X("--additionalprobingpath")) ? opts.find(_X("--additionalprobingpath"))->second : std::vector<pal::string_t>();
+
+    if (!deps_file.empty() && (!pal::realpath(&deps_file) || !pal::file_exists(deps_file)))
+    {
+        trace::error(_X("The specified deps.json [%s] does not exist"), deps_file.c_str());
+        return StatusCode::InvalidArgFailure;
+    }
+
+    pal::string_t config_file, dev_config_file;
+    if (runtime_config.empty())
+    {
+        get_runtime_config_paths_from_app(app, &config_file, &dev_config_file);
+    }
+    else
+    {
+        get_runtime_config_paths_from_arg(runtime_config, &config_file, &dev_config_file);
+    }
+
+    runtime_config_t config(config_file, dev_config_file);
+    if (!config.is_valid())
+    {
+        trace::error(_X("Invalid runtimeconfig.json [%s] [%s]"), config.get_path().c_str(), config.get_dev_path().c_str());
+        return StatusCode::InvalidConfigFile;
+    }
+
+    if (config.get_portable())
+    {
+        if (fx_dir.empty() || !pal::realpath(&fx_dir))
+        {
+            trace::error(_X("A portable application needs the --fx-dir it runs on"));
+            return StatusCode::InvalidArgFailure;
+        }
+    }
+    else
+    {
+        fx_dir.clear();
+    }
+
+    // Probe paths in the order hostfxr passes them to hostpolicy.
+    std::vector<pal::string_t> probe_realpaths;
+    for (const auto& path : spec_probe_paths)
+    {
+        pal::string_t real = path;
+        if (pal::realpath(&real))
+        {
+            probe_realpaths.push_back(real);
+        }
+    }
+    for (const auto& path : config.get_probe_paths())
+    {
+        pal::string_t real = path;
+        if (pal::realpath(&real))
+        {
+            probe_realpaths.push_back(real);
+        }
+    }
+
+    host_mode_t mode = config.get_portable() ? host_mode_t::muxer : host_mode_t::standalone;
+    corehost_init_t host_init(deps_file, probe_realpaths, fx_dir, mode, config);
+    host_interface_t host_interface = host_init.get_host_init_data();
+
+    hostpolicy_init_t init;
+    if (!hostpolicy_init_t::init(&host_interface, &init))
+    {
+        return StatusCode::LibHostInitFailure;
+    }
+
+    // The arguments as parse_arguments would read them for the app.
+    arguments_t args;
+    args.managed_application = app;
+    args.app_dir = get_directory(app);
+    args.probe_paths = init.probe_paths;
+    if (!init.deps_file.empty())
+    {
+        args.deps_path = init.deps_file;
+        args.app_dir = get_directory(args.deps_path);
+    }
+    else
+    {
+        args.deps_path = strip_file_ext(app) + _X(".deps.json");
+    }
+    pal::getenv(_X("DOTNET_HOSTING_OPTIMIZATION_CACHE"), &args.dotnet_packages_cache);
+    pal::get_default_servicing_directory(&args.core_servicing);
+    args.print();
+
+    launch_manifest_t manifest;
+    int code = launch_manifest::resolve(init, args, false, &manifest);
+    if (code != StatusCode::Success)
+    {
+        return code;
+    }
+
+    pal::string_t manifest_file = launch_manifest::get_manifest_file(args);
+    if (!launch_manifest::write(manifest_file, manifest))
+    {
+        return StatusCode::InvalidArgFailure;
+    }
+
+    trace::println(_X("Wrote the launch manifest [%s]"), manifest_file.c_str());
+    return StatusCode::Success;
+}
+
+int index_cache(const int argc, const pal::char_t* argv[])
+{
+    if (argc < 3)
+    {
+        return usage();
+    }
+
+    for (int i = 2; i < argc; ++i)
+    {
+        pal::string_t root = argv[i];
+        if (!pal::realpath(&root))
+        {
+            trace::error(_X("The cache directory [%s] does not exist"), argv[i]);
+            return StatusCode::InvalidArgFailure;
+        }
+
+        size_t count;
+        if (!hash_index_t::build(root, &count))
+        {
+            return StatusCode::InvalidArgFailure;
+        }
+        trace::println(_X("Wrote the hash index [%s] of %d package hashes"), hash_index_t::get_index_file(root).c_str(), (int) count);
+    }
+    return StatusCode::Success;
+}
+
+#if defined(_WIN32)
+int __cdecl wmain(const int argc, const pal::char_t* argv[])
+#else
+int main(const int argc, const pal::char_t* argv[])
+#endif
+{
+    trace::setup();
+    if (argc > 1 && pal::strcmp(argv[1], _X("index-cache")) == 0)
+    {
+        return index_cache(argc, argv);
+    }
+    int code = generate(argc, argv);
+    probe_filter_t::wait_for_builds();
+    return code;
+}
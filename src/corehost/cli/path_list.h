@@ -0,0 +1,53 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __PATH_LIST_H_
+#define __PATH_LIST_H_
+
+#include <vector>
+#include "pal.h"
+
+// Builds a list of paths, each followed by PATH_SEPARATOR, like the TPA and
+// the native and resources search paths passed to CoreCLR.
+//
+// The paths are collected by reference and copied once, into a string of the
+// exact size of the list, so a list of hundreds of KB is not grown and copied
+// path by path. The paths must outlive the builder.
+class path_list_builder_t
+{
+public:
+    path_list_builder_t()
+        : m_size(0)
+    {
+    }
+
+    void add(const pal::string_t* path)
+    {
+        m_paths.push_back(path);
+        m_size += path->length() + 1;
+    }
+
+    void append(const path_list_builder_t& other)
+    {
+        m_paths.insert(m_paths.end(), other.m_paths.begin(), other.m_paths.end());
+        m_size += other.m_size;
+    }
+
+    void build(pal::string_t* output) const
+    {
+        output->clear();
+        output->reserve(m_size);
+        for (const pal::string_t* path : m_paths)
+        {
+            output->append(*path);
+            output->push_back(PATH_SEPARATOR);
+        }
+        assert(output->length() == m_size);
+    }
+
+private:
+    std::vector<const pal::string_t*> m_paths;
+    size_t m_size;
+};
+
+#endif // __PATH_LIST_H_
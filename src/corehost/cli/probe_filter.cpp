@@ -0,0 +1,387 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <system_error>
+
+#include "probe_filter.h"
+#include "binary_io.h"
+#include "deps_cache.h"
+#include "dir_cache.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+const uint32_t s_filter_magic = 0x464d4c42; // "BLMF"
+const uint32_t s_filter_version = 1;
+
+// About 1% of the files that are not there are still probed.
+const size_t s_bits_per_key = 10;
+const uint32_t s_hashes = 7;
+
+// The package versions with files deeper than this are not filtered.
+const size_t s_max_depth = 16;
+
+// A build that has not finished in this long, in seconds, is taken to have
+// been cut short, as by its process exiting, and may be started again.
+const int64_t s_build_timeout = 10 * 60;
+
+// The builds started by this module, stopped and joined before it is
+// unloaded. They are never destroyed, so that a build still running at exit
+// does not outlive them.
+struct builds_t
+{
+    std::mutex lock;
+    std::vector<std::thread> threads;
+    std::atomic<bool> stop;
+
+    builds_t() : stop(false) { }
+};
+
+builds_t& get_builds()
+{
+    static builds_t* builds = new builds_t();
+    return *builds;
+}
+
+// Take the lock file of a build, which makes a single process at a time walk
+// the root, however many launch meanwhile.
+bool lock_build(const pal::string_t& lock_file)
+{
+    if (pal::touch_file(lock_file))
+    {
+        return true;
+    }
+
+    int64_t age;
+    if (!pal::get_file_age(lock_file, &age) || age < s_build_timeout)
+    {
+        return false;
+    }
+    trace::verbose(_X("Taking over the build of the probe filter locked by [%s] since %d seconds"), lock_file.c_str(), (int) age);
+    (void) pal::remove(lock_file);
+    return pal::touch_file(lock_file);
+}
+
+pal::string_t get_version_key(const pal::string_t& name, const pal::string_t& version)
+{
+    return dir_cache_t::to_name_key(name) + _X("/") + dir_cache_t::to_name_key(version);
+}
+
+uint64_t hash_key(const pal::string_t& key)
+{
+    return deps_cache::hash(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(pal::char_t));
+}
+
+bool get_cache_file(const pal::string_t& root, pal::string_t* cache_file)
+{
+    pal::string_t cache_dir;
+    if (!get_host_cache_dir(&cache_dir))
+    {
+        return false;
+    }
+
+    pal::stringstream_t name;
+    name << std::hex << hash_key(root) << _X(".probe.cache");
+
+    cache_file->assign(cache_dir);
+    append_path(cache_file, name.str().c_str());
+    return true;
+}
+} // end of anonymous namespace
+
+probe_filter_t::probe_filter_t()
+    : m_hashes(0)
+{
+    m_stamp.size = 0;
+    m_stamp.mtime = 0;
+    m_stamp.id = 0;
+}
+
+bool probe_filter_t::load(const pal::string_t& root)
+{
+    m_root = root;
+
+    pal::string_t cache_file;
+    if (!get_cache_file(root, &cache_file))
+    {
+        return false;
+    }
+
+    pal::file_stamp_t stamp;
+    if (read(cache_file) && pal::get_file_stamp(root, &stamp) &&
+        stamp.size == m_stamp.size && stamp.mtime == m_stamp.mtime)
+    {
+        trace::verbose(_X("Read the probe filter [%s] of %d package versions"), cache_file.c_str(), m_versions.size());
+        return true;
+    }
+
+    // The run goes on without the filter while it is built for the next runs.
+    pal::string_t lock_file = cache_file + _X(".lock");
+    if (!lock_build(lock_file))
+    {
+        trace::verbose(_X("The probe filter [%s] is being built by another run"), cache_file.c_str());
+        return false;
+    }
+    trace::verbose(_X("Building the probe filter [%s] of [%s] in the background"), cache_file.c_str(), root.c_str());
+
+    builds_t& builds = get_builds();
+    std::lock_guard<std::mutex> lock(builds.lock);
+    try
+    {
+        builds.threads.push_back(std::thread(rebuild, root, cache_file, lock_file));
+    }
+    catch (const std::system_error&)
+    {
+        trace::verbose(_X("Could not start a thread to build the probe filter"));
+        (void) pal::remove(lock_file);
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Stop the builds, which leave no filter behind, so that the run does not wait
+// for a walk of a large root to end. The next run that misses the filter
+// builds it again.
+//
+void probe_filter_t::stop_builds()
+{
+    builds_t& builds = get_builds();
+    builds.stop = true;
+    wait_for_builds();
+    builds.stop = false;
+}
+
+void probe_filter_t::wait_for_builds()
+{
+    std::vector<std::thread> threads;
+    {
+        builds_t& builds = get_builds();
+        std::lock_guard<std::mutex> lock(builds.lock);
+        threads.swap(builds.threads);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+bool probe_filter_t::excludes(const pal::string_t& name, const pal::string_t& version, const pal::string_t& relative_path) const
+{
+    pal::string_t key = get_version_key(name, version);
+    if (!std::binary_search(m_versions.begin(), m_versions.end(), key))
+    {
+        return false;
+    }
+    key.push_back(_X('/'));
+    key.append(dir_cache_t::to_name_key(relative_path));
+    return !test(key);
+}
+
+void probe_filter_t::rebuild(const pal::string_t& root, const pal::string_t& cache_file, const pal::string_t& lock_file)
+{
+    probe_filter_t filter;
+    filter.m_root = root;
+    if (filter.walk())
+    {
+        filter.write(cache_file);
+    }
+    (void) pal::remove(lock_file);
+}
+
+// -----------------------------------------------------------------------------
+// Read the files of the package versions of the root. The root is stamped
+// first, so a package added during the walk makes the filter out of date.
+//
+// Only the versions NuGet finished extracting are read, as it writes the
+// "<name>.<version>.nupkg.sha512" marker of a version last. The files of a
+// version that is still being extracted are then never ruled out.
+//
+// Returns false if the root could not be read or the builds were stopped.
+//
+bool probe_filter_t::walk()
+{
+    std::vector<pal::string_t> names;
+    if (!pal::get_file_stamp(m_root, &m_stamp) || !pal::list_dir(m_root, &names))
+    {
+        return false;
+    }
+
+    const std::atomic<bool>& stop = get_builds().stop;
+
+    std::vector<pal::string_t> keys;
+    for (const auto& name : names)
+    {
+        pal::string_t package_dir = m_root;
+        append_path(&package_dir, name.c_str());
+
+        std::vector<pal::string_t> versions;
+        if (!pal::list_dir(package_dir, &versions))
+        {
+            continue;
+        }
+        for (const auto& version : versions)
+        {
+            pal::string_t version_dir = package_dir;
+            append_path(&version_dir, version.c_str());
+
+            pal::string_t marker = version_dir;
+            append_path(&marker, (name + _X(".") + version + _X(".nupkg.sha512")).c_str());
+            if (!pal::file_exists(marker))
+            {
+                continue;
+            }
+
+            pal::string_t prefix = get_version_key(name, version);
+            std::vector<pal::string_t> version_keys;
+            bool complete = walk_files(version_dir, prefix + _X("/"), 0, &version_keys);
+            if (stop)
+            {
+                trace::verbose(_X("Stopped building the probe filter of [%s]"), m_root.c_str());
+                return false;
+            }
+            if (!complete)
+            {
+                trace::verbose(_X("Not filtering the files of [%s], which has directory links or is too deep"), version_dir.c_str());
+                continue;
+            }
+            m_versions.push_back(prefix);
+            keys.insert(keys.end(), version_keys.begin(), version_keys.end());
+        }
+    }
+    std::sort(m_versions.begin(), m_versions.end());
+    fill(keys);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Read the files under "dir". Links to directories are not followed, so the
+// walk fails if there are any, as it does below s_max_depth, rather than miss
+// the files below. It also fails once the builds are stopped.
+//
+bool probe_filter_t::walk_files(const pal::string_t& dir, const pal::string_t& prefix, size_t depth, std::vector<pal::string_t>* keys)
+{
+    std::vector<pal::dir_entry_t> entries;
+    if (get_builds().stop || !pal::list_dir(dir, &entries))
+    {
+        return false;
+    }
+    for (const auto& entry : entries)
+    {
+        // Relative paths in the deps file always use '/'.
+        pal::string_t key = prefix + dir_cache_t::to_name_key(entry.name);
+        keys->push_back(key);
+        if (!entry.is_dir)
+        {
+            continue;
+        }
+        if (entry.is_link || depth == s_max_depth)
+        {
+            return false;
+        }
+
+        pal::string_t path = dir;
+        append_path(&path, entry.name.c_str());
+        key.push_back(_X('/'));
+        if (!walk_files(path, key, depth + 1, keys))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void probe_filter_t::fill(const std::vector<pal::string_t>& keys)
+{
+    size_t bits = std::max<size_t>(keys.size() * s_bits_per_key, 64);
+    m_bits.assign((bits + 7) / 8, '\0');
+    m_hashes = s_hashes;
+    for (const auto& key : keys)
+    {
+        uint64_t hash = hash_key(key);
+        uint32_t h1 = (uint32_t) hash;
+        uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+        for (uint32_t i = 0; i < m_hashes; ++i)
+        {
+            size_t bit = (h1 + (uint64_t) i * h2) % (m_bits.size() * 8);
+            m_bits[bit / 8] |= (char) (1 << (bit % 8));
+        }
+    }
+}
+
+bool probe_filter_t::test(const pal::string_t& key) const
+{
+    if (m_hashes == 0 || m_bits.empty())
+    {
+        return true;
+    }
+
+    uint64_t hash = hash_key(key);
+    uint32_t h1 = (uint32_t) hash;
+    uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+    for (uint32_t i = 0; i < m_hashes; ++i)
+    {
+        size_t bit = (h1 + (uint64_t) i * h2) % (m_bits.size() * 8);
+        if ((m_bits[bit / 8] & (1 << (bit % 8))) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool probe_filter_t::read(const pal::string_t& cache_file)
+{
+    pal::ifstream_t file(cache_file, std::ios::binary);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    std::string bytes;
+    bytes.assign(pal::istreambuf_iterator_t(file), pal::istreambuf_iterator_t());
+
+    binary_reader_t reader(bytes.data(), bytes.data() + bytes.size());
+    uint32_t magic, version, char_size;
+    uint64_t mtime;
+    pal::string_t root;
+    bool valid = reader.read_u32(&magic) && magic == s_filter_magic &&
+        reader.read_u32(&version) && version == s_filter_version &&
+        reader.read_u32(&char_size) && char_size == sizeof(pal::char_t) &&
+        reader.read_string(&root) && root == m_root &&
+        reader.read_u64(&m_stamp.size) && reader.read_u64(&mtime) &&
+        reader.read_strings(&m_versions) &&
+        reader.read_u32(&m_hashes) && m_hashes != 0 &&
+        reader.read_bytes(&m_bits) && !m_bits.empty() &&
+        reader.at_end();
+    m_stamp.mtime = (int64_t) mtime;
+    if (!valid)
+    {
+        trace::verbose(_X("Ignoring the probe filter [%s] as it could not be read"), cache_file.c_str());
+        m_versions.clear();
+        m_hashes = 0;
+        m_bits.clear();
+    }
+    return valid;
+}
+
+bool probe_filter_t::write(const pal::string_t& cache_file) const
+{
+    std::string bytes;
+    binary_writer_t writer(&bytes);
+
+    writer.write_u32(s_filter_magic);
+    writer.write_u32(s_filter_version);
+    writer.write_u32(sizeof(pal::char_t));
+    writer.write_string(m_root);
+    writer.write_u64(m_stamp.size);
+    writer.write_u64((uint64_t) m_stamp.mtime);
+    writer.write_strings(m_versions);
+    writer.write_u32(m_hashes);
+    writer.write_bytes(m_bits);
+
+    return write_file_atomically(cache_file, bytes);
+}
@@ -0,0 +1,56 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __PROBE_FILTER_H_
+#define __PROBE_FILTER_H_
+
+#include <vector>
+#include <string>
+#include "pal.h"
+
+// A Bloom filter of the files in the package versions of a probe root, so
+// that probing for an asset that is definitely not there skips the file
+// system.
+//
+// The filter is only read from the host cache directory, where it is cached
+// against the stamp of the root. When there is no current filter, one is built
+// on a background thread for the runs that follow, by one process at a time.
+// Package version directories are taken not to change once NuGet finished
+// extracting them, so the filter only rules out files in the versions it
+// walked; others are always probed.
+class probe_filter_t
+{
+public:
+    probe_filter_t();
+
+    // Read the filter of the root "root", or start building it in the
+    // background if it is missing or out of date.
+    bool load(const pal::string_t& root);
+
+    // Whether the file "relative_path" of version "version" of package "name"
+    // is definitely not in the root.
+    bool excludes(const pal::string_t& name, const pal::string_t& version, const pal::string_t& relative_path) const;
+
+    // Stop building filters in the background, before the code that builds
+    // them is unloaded, or wait for the builds to finish.
+    static void stop_builds();
+    static void wait_for_builds();
+
+private:
+    bool walk();
+    bool walk_files(const pal::string_t& dir, const pal::string_t& prefix, size_t depth, std::vector<pal::string_t>* keys);
+    void fill(const std::vector<pal::string_t>& keys);
+    bool test(const pal::string_t& key) const;
+    bool read(const pal::string_t& cache_file);
+    bool write(const pal::string_t& cache_file) const;
+
+    static void rebuild(const pal::string_t& root, const pal::string_t& cache_file, const pal::string_t& lock_file);
+
+    pal::string_t m_root;
+    pal::file_stamp_t m_stamp;
+    std::vector<pal::string_t> m_versions; // Sorted "<name>/<version>" keys.
+    uint32_t m_hashes;
+    std::string m_bits;
+};
+
+#endif // __PROBE_FILTER_H_
@@ -0,0 +1,125 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <thread>
+#include <system_error>
+
+#include "probe_index.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+struct root_listing_t
+{
+    bool exists;
+    std::vector<pal::string_t> names;
+
+    root_listing_t()
+        : exists(false)
+    {
+    }
+};
+} // end of anonymous namespace
+
+const size_t probe_index_t::max_roots;
+
+probe_index_t::probe_index_t()
+{
+}
+
+void probe_index_t::set_roots(const std::vector<pal::string_t>& roots)
+{
+    m_roots.assign(roots.begin(), roots.begin() + std::min(roots.size(), max_roots));
+    m_names.clear();
+    m_versions.clear();
+}
+
+// -----------------------------------------------------------------------------
+// List the package directories of the roots, each root on its own thread, and
+// keep the listings in "dir_cache" for the probes that follow.
+//
+void probe_index_t::build(dir_cache_t* dir_cache)
+{
+    std::vector<root_listing_t> listings(m_roots.size());
+    auto list_root = [this, &listings](size_t i) {
+        listings[i].exists = pal::list_dir(m_roots[i], &listings[i].names);
+    };
+
+    // The first root is listed on this thread while the others are listed.
+    std::vector<std::thread> listers;
+    for (size_t i = 1; i < m_roots.size(); ++i)
+    {
+        try
+        {
+            listers.push_back(std::thread(list_root, i));
+        }
+        catch (const std::system_error&)
+        {
+            trace::verbose(_X("Could not start a thread to list [%s], listing it inline"), m_roots[i].c_str());
+            list_root(i);
+        }
+    }
+    if (!m_roots.empty())
+    {
+        list_root(0);
+    }
+    for (auto& lister : listers)
+    {
+        lister.join();
+    }
+
+    for (size_t i = 0; i < m_roots.size(); ++i)
+    {
+        const uint64_t bit = 1ULL << i;
+        for (const auto& name : listings[i].names)
+        {
+            m_names[dir_cache_t::to_name_key(name)] |= bit;
+        }
+        dir_cache->add_listing(m_roots[i], listings[i].exists, listings[i].names);
+    }
+
+    trace::verbose(_X("Indexed %d probe roots: %d packages"), m_roots.size(), m_names.size());
+}
+
+uint64_t probe_index_t::find(const pal::string_t& name, const pal::string_t& version, dir_cache_t* dir_cache)
+{
+    std::call_once(m_built, &probe_index_t::build, this, dir_cache);
+
+    pal::string_t name_key = dir_cache_t::to_name_key(name);
+    pal::string_t key = name_key + _X("/") + dir_cache_t::to_name_key(version);
+    {
+        std::lock_guard<std::mutex> lock(m_versions_lock);
+        auto iter = m_versions.find(key);
+        if (iter != m_versions.end())
+        {
+            return iter->second;
+        }
+    }
+
+    // The version directories are looked up in the listings of the dir cache,
+    // which has its own lock.
+    uint64_t mask = 0;
+    auto name_iter = m_names.find(name_key);
+    if (name_iter != m_names.end())
+    {
+        for (size_t i = 0; i < m_roots.size(); ++i)
+        {
+            const uint64_t bit = 1ULL << i;
+            if ((name_iter->second & bit) == 0)
+            {
+                continue;
+            }
+            pal::string_t package_dir = m_roots[i];
+            append_path(&package_dir, name.c_str());
+            if (dir_cache->contains(package_dir, version))
+            {
+                mask |= bit;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_versions_lock);
+    m_versions.emplace(key, mask);
+    return mask;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __PROBE_INDEX_H_
+#define __PROBE_INDEX_H_
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "pal.h"
+#include "dir_cache.h"
+
+// Which of several package layout roots, in priority order, have a package
+// version. The roots are listed in parallel on the first lookup; the version
+// directories of a package are only listed when it is looked up.
+//
+// A lookup returns a mask with bit i set for each root i that has the version.
+// Only the first max_roots roots are indexed; the others are never excluded.
+//
+// Lookups can be made by several threads at once. The roots are listed once,
+// and no lock is held while the file system is read.
+class probe_index_t
+{
+public:
+    static const size_t max_roots = 64;
+
+    probe_index_t();
+
+    // Set the roots, before the first lookup.
+    void set_roots(const std::vector<pal::string_t>& roots);
+
+    uint64_t find(const pal::string_t& name, const pal::string_t& version, dir_cache_t* dir_cache);
+
+private:
+    void build(dir_cache_t* dir_cache);
+
+    std::vector<pal::string_t> m_roots;
+    std::once_flag m_built;
+
+    // Package name -> roots with the package directory, read only once built.
+    std::unordered_map<pal::string_t, uint64_t> m_names;
+
+    // "<name>/<version>" -> roots with the version directory.
+    std::mutex m_versions_lock;
+    std::unordered_map<pal::string_t, uint64_t> m_versions;
+};
+
+#endif // __PROBE_INDEX_H_
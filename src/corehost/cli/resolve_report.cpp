@@ -0,0 +1,290 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include "resolve_report.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+// The number of entries in the summary of the slowest entries.
+const size_t s_slowest_entries = 20;
+
+const pal::io_counters_t s_no_io = { 0, 0, 0, 0 };
+
+uint64_t count_syscalls(const pal::io_counters_t& io)
+{
+    return io.stats + io.dirs + io.opens + io.batches;
+}
+
+void add_io(pal::io_counters_t* total, const pal::io_counters_t& io)
+{
+    total->stats += io.stats;
+    total->dirs += io.dirs;
+    total->opens += io.opens;
+    total->batches += io.batches;
+}
+
+void append_number(std::string* out, uint64_t value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long) value);
+    out->append(buffer);
+}
+
+// Append "str" as a JSON string, in UTF-8.
+void append_string(std::string* out, const pal::string_t& str)
+{
+    std::vector<char> utf8;
+    pal::pal_clrstring(str, &utf8);
+
+    out->push_back('"');
+    for (const char* c = utf8.data(); *c != '\0'; ++c)
+    {
+        switch (*c)
+        {
+        case '"':
+            out->append("\\\"");
+            break;
+        case '\\':
+            out->append("\\\\");
+            break;
+        default:
+            if ((unsigned char) *c < 0x20)
+            {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned int) (unsigned char) *c);
+                out->append(buffer);
+            }
+            else
+            {
+                out->push_back(*c);
+            }
+            break;
+        }
+    }
+    out->push_back('"');
+}
+
+void append_io(std::string* out, const pal::io_counters_t& io)
+{
+    out->append(",\"syscalls\":");
+    append_number(out, count_syscalls(io));
+    out->append(",\"stats\":");
+    append_number(out, io.stats);
+    out->append(",\"dirs\":");
+    append_number(out, io.dirs);
+    out->append(",\"opens\":");
+    append_number(out, io.opens);
+    out->append(",\"batches\":");
+    append_number(out, io.batches);
+}
+} // end of anonymous namespace
+
+bool resolve_report_t::get_report_file(pal::string_t* report_file)
+{
+    return pal::getenv(_X("COREHOST_RESOLVE_REPORT"), report_file) && !report_file->empty();
+}
+
+resolve_report_t::resolve_report_t(const pal::string_t& report_file)
+    : m_report_file(report_file)
+{
+}
+
+void resolve_report_t::set_probe_dirs(const std::vector<pal::string_t>& probe_dirs)
+{
+    m_probe_dirs = probe_dirs;
+}
+
+void resolve_report_t::begin_pass(const pal::char_t* pass)
+{
+    m_passes.push_back({ pass, 0, 0 });
+    m_pass_start = std::chrono::steady_clock::now();
+}
+
+void resolve_report_t::end_pass()
+{
+    assert(!m_passes.empty());
+    auto elapsed = std::chrono::steady_clock::now() - m_pass_start;
+    m_passes.back().ns = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+void resolve_report_t::add_entry(const deps_entry_t& entry, const std::vector<probe_t>& probes)
+{
+    assert(!m_passes.empty());
+    m_passes.back().entries++;
+
+    entry_t row;
+    row.pass = m_passes.size() - 1;
+    row.entry = &entry;
+    row.probes = probes;
+    row.ns = 0;
+    row.syscalls = 0;
+    for (const auto& probe : probes)
+    {
+        if (!probe.cached)
+        {
+            row.ns += probe.ns;
+            row.syscalls += count_syscalls(probe.io);
+        }
+    }
+    m_entries.push_back(std::move(row));
+}
+
+// -----------------------------------------------------------------------------
+// Write the report as one JSON document: the passes, the probe dirs and the
+// slowest entries first, then a line per entry and pass.
+//
+bool resolve_report_t::write() const
+{
+    std::string out;
+    out.append("{\n\"passes\":[");
+    for (size_t i = 0; i < m_passes.size(); ++i)
+    {
+        const pass_t& pass = m_passes[i];
+        pal::io_counters_t io = s_no_io;
+        for (const auto& row : m_entries)
+        {
+            if (row.pass != i)
+            {
+                continue;
+            }
+            for (const auto& probe : row.probes)
+            {
+                if (!probe.cached)
+                {
+                    add_io(&io, probe.io);
+                }
+            }
+        }
+
+        out.append(i == 0 ? "\n" : ",\n");
+        out.append("{\"pass\":");
+        append_string(&out, pass.name);
+        out.append(",\"ns\":");
+        append_number(&out, pass.ns);
+        out.append(",\"entries\":");
+        append_number(&out, pass.entries);
+        append_io(&out, io);
+        out.append("}");
+    }
+
+    // The probe dirs, with the cost of the probes made in each.
+    std::vector<uint64_t> dir_ns(m_probe_dirs.size(), 0);
+    std::vector<uint64_t> dir_probes(m_probe_dirs.size(), 0);
+    std::vector<uint64_t> dir_matches(m_probe_dirs.size(), 0);
+    std::vector<pal::io_counters_t> dir_io(m_probe_dirs.size(), s_no_io);
+    for (const auto& row : m_entries)
+    {
+        for (const auto& probe : row.probes)
+        {
+            if (probe.cached || probe.probe_dir >= m_probe_dirs.size())
+            {
+                continue;
+            }
+            dir_ns[probe.probe_dir] += probe.ns;
+            dir_probes[probe.probe_dir]++;
+            dir_matches[probe.probe_dir] += probe.found ? 1 : 0;
+            add_io(&dir_io[probe.probe_dir], probe.io);
+        }
+    }
+    out.append("\n],\n\"probe_dirs\":[");
+    for (size_t i = 0; i < m_probe_dirs.size(); ++i)
+    {
+        out.append(i == 0 ? "\n" : ",\n");
+        out.append("{\"index\":");
+        append_number(&out, i);
+        out.append(",\"dir\":");
+        append_string(&out, m_probe_dirs[i]);
+        out.append(",\"probes\":");
+        append_number(&out, dir_probes[i]);
+        out.append(",\"matches\":");
+        append_number(&out, dir_matches[i]);
+        out.append(",\"ns\":");
+        append_number(&out, dir_ns[i]);
+        append_io(&out, dir_io[i]);
+        out.append("}");
+    }
+
+    auto append_entry = [this, &out](const entry_t& row)
+    {
+        const deps_entry_t& entry = *row.entry;
+        out.append("{\"pass\":");
+        append_string(&out, m_passes[row.pass].name);
+        out.append(",\"library\":");
+        append_string(&out, entry.library_name);
+        out.append(",\"version\":");
+        append_string(&out, entry.library_version);
+        out.append(",\"path\":");
+        append_string(&out, entry.relative_path);
+        out.append(",\"matched\":");
+        auto matched = std::find_if(row.probes.begin(), row.probes.end(), [](const probe_t& probe) { return probe.found; });
+        if (matched == row.probes.end())
+        {
+            out.append("null");
+        }
+        else
+        {
+            append_number(&out, matched->probe_dir);
+        }
+        out.append(",\"ns\":");
+        append_number(&out, row.ns);
+        out.append(",\"syscalls\":");
+        append_number(&out, row.syscalls);
+        out.append(",\"probes\":[");
+        for (size_t i = 0; i < row.probes.size(); ++i)
+        {
+            const probe_t& probe = row.probes[i];
+            out.append(i == 0 ? "{\"dir\":" : ",{\"dir\":");
+            append_number(&out, probe.probe_dir);
+            out.append(probe.found ? ",\"found\":true" : ",\"found\":false");
+            if (probe.cached)
+            {
+                out.append(",\"cached\":true}");
+                continue;
+            }
+            out.append(",\"ns\":");
+            append_number(&out, probe.ns);
+            append_io(&out, probe.io);
+            out.append("}");
+        }
+        out.append("]}");
+    };
+
+    std::vector<const entry_t*> slowest;
+    slowest.reserve(m_entries.size());
+    for (const auto& row : m_entries)
+    {
+        slowest.push_back(&row);
+    }
+    size_t slowest_count = std::min(slowest.size(), s_slowest_entries);
+    std::partial_sort(slowest.begin(), slowest.begin() + slowest_count, slowest.end(), [](const entry_t* a, const entry_t* b)
+    {
+        return a->ns > b->ns;
+    });
+    out.append("\n],\n\"slowest_entries\":[");
+    for (size_t i = 0; i < slowest_count; ++i)
+    {
+        out.append(i == 0 ? "\n" : ",\n");
+        append_entry(*slowest[i]);
+    }
+
+    out.append("\n],\n\"entries\":[");
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        out.append(i == 0 ? "\n" : ",\n");
+        append_entry(m_entries[i]);
+    }
+    out.append("\n]\n}\n");
+
+    if (!write_file_atomically(m_report_file, out))
+    {
+        trace::warning(_X("Could not write the resolve report [%s]"), m_report_file.c_str());
+        return false;
+    }
+    return true;
+}
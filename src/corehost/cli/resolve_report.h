@@ -0,0 +1,73 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __RESOLVE_REPORT_H_
+#define __RESOLVE_REPORT_H_
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include "pal.h"
+#include "deps_entry.h"
+
+// A report of where the time and the file system calls of a resolution went,
+// for the file named by COREHOST_RESOLVE_REPORT. Unlike the trace, it is kept
+// in memory and written as one JSON document once the resolution is done, so
+// it barely changes the timing it reports.
+//
+// The report has a row per entry and pass with the probe dirs tried, the one
+// that matched and what each probe cost, and a summary of the passes, the
+// probe dirs and the slowest entries. A probe is only costed in the pass that
+// made it; later passes that use its result show it as cached.
+class resolve_report_t
+{
+public:
+    // The outcome and cost of probing an entry in a probe dir.
+    struct probe_t
+    {
+        size_t probe_dir;
+        bool found;
+        bool cached;
+        uint64_t ns;
+        pal::io_counters_t io;
+    };
+
+    // The file to write the report to, if one is asked for.
+    static bool get_report_file(pal::string_t* report_file);
+
+    explicit resolve_report_t(const pal::string_t& report_file);
+
+    void set_probe_dirs(const std::vector<pal::string_t>& probe_dirs);
+
+    void begin_pass(const pal::char_t* pass);
+    void end_pass();
+
+    void add_entry(const deps_entry_t& entry, const std::vector<probe_t>& probes);
+
+    bool write() const;
+
+private:
+    struct entry_t
+    {
+        size_t pass;
+        const deps_entry_t* entry;
+        std::vector<probe_t> probes;
+        uint64_t ns;
+        uint64_t syscalls;
+    };
+
+    struct pass_t
+    {
+        const pal::char_t* name;
+        uint64_t ns;
+        size_t entries;
+    };
+
+    pal::string_t m_report_file;
+    std::vector<pal::string_t> m_probe_dirs;
+    std::vector<pass_t> m_passes;
+    std::vector<entry_t> m_entries;
+    std::chrono::steady_clock::time_point m_pass_start;
+};
+
+#endif // __RESOLVE_REPORT_H_
@@ -0,0 +1,191 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "servicing_index.h"
+#include "binary_io.h"
+#include "deps_cache.h"
+#include "dir_cache.h"
+#include "utils.h"
+#include "trace.h"
+
+namespace
+{
+const uint32_t s_index_magic = 0x49435653; // "SVCI"
+const uint32_t s_index_version = 1;
+
+pal::string_t get_package_key(const pal::string_t& name, const pal::string_t& version)
+{
+    return dir_cache_t::to_name_key(name) + _X("/") + dir_cache_t::to_name_key(version);
+}
+
+bool get_cache_file(const pal::string_t& root, pal::string_t* cache_file)
+{
+    pal::string_t cache_dir;
+    if (!get_host_cache_dir(&cache_dir))
+    {
+        return false;
+    }
+
+    pal::stringstream_t name;
+    name << std::hex << deps_cache::hash(reinterpret_cast<const char*>(root.data()), root.size() * sizeof(pal::char_t)) << _X(".svc.cache");
+
+    cache_file->assign(cache_dir);
+    append_path(cache_file, name.str().c_str());
+    return true;
+}
+} // end of anonymous namespace
+
+void servicing_index_t::load(const pal::string_t& root)
+{
+    m_root = root;
+
+    pal::string_t cache_file;
+    bool cached = get_cache_file(root, &cache_file);
+    if (cached && read(cache_file))
+    {
+        if (is_current())
+        {
+            trace::verbose(_X("Read the servicing index [%s] of %d packages"), cache_file.c_str(), m_packages.size());
+            return;
+        }
+        trace::verbose(_X("The servicing index [%s] is out of date"), cache_file.c_str());
+    }
+
+    walk(cached);
+    trace::verbose(_X("Indexed the servicing store [%s]: %d packages"), root.c_str(), m_packages.size());
+    if (cached && !m_stamps.empty())
+    {
+        write(cache_file);
+    }
+}
+
+bool servicing_index_t::contains(const pal::string_t& name, const pal::string_t& version) const
+{
+    return std::binary_search(m_packages.begin(), m_packages.end(), get_package_key(name, version));
+}
+
+void servicing_index_t::get_dirs(std::vector<pal::string_t>* dirs) const
+{
+    for (const auto& entry : m_stamps)
+    {
+        dirs->push_back(entry.path);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Read the package versions from the package directories of the store, and
+// stamp the directories read if "stamp" is set. Adding or removing a package
+// or one of its versions changes the stamp of the directory it is listed in.
+//
+void servicing_index_t::walk(bool stamp)
+{
+    m_stamps.clear();
+    m_packages.clear();
+
+    dir_stamp_t root_stamp;
+    std::vector<pal::string_t> names;
+    if ((stamp && !pal::get_file_stamp(m_root, &root_stamp.stamp)) || !pal::list_dir(m_root, &names))
+    {
+        return;
+    }
+    root_stamp.path = m_root;
+    m_stamps.push_back(root_stamp);
+
+    for (const auto& name : names)
+    {
+        dir_stamp_t package_stamp;
+        package_stamp.path = m_root;
+        append_path(&package_stamp.path, name.c_str());
+
+        std::vector<pal::string_t> versions;
+        if ((stamp && !pal::get_file_stamp(package_stamp.path, &package_stamp.stamp)) || !pal::list_dir(package_stamp.path, &versions))
+        {
+            continue;
+        }
+        m_stamps.push_back(package_stamp);
+
+        for (const auto& version : versions)
+        {
+            m_packages.push_back(get_package_key(name, version));
+        }
+    }
+    std::sort(m_packages.begin(), m_packages.end());
+}
+
+bool servicing_index_t::is_current() const
+{
+    for (const auto& entry : m_stamps)
+    {
+        pal::file_stamp_t stamp;
+        if (!pal::get_file_stamp(entry.path, &stamp) || stamp.size != entry.stamp.size || stamp.mtime != entry.stamp.mtime)
+        {
+            return false;
+        }
+    }
+    return !m_stamps.empty();
+}
+
+bool servicing_index_t::read(const pal::string_t& cache_file)
+{
+    pal::ifstream_t file(cache_file, std::ios::binary);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    std::string bytes;
+    bytes.assign(pal::istreambuf_iterator_t(file), pal::istreambuf_iterator_t());
+
+    binary_reader_t reader(bytes.data(), bytes.data() + bytes.size());
+    uint32_t magic, version, char_size, count;
+    pal::string_t root;
+    bool valid = reader.read_u32(&magic) && magic == s_index_magic &&
+        reader.read_u32(&version) && version == s_index_version &&
+        reader.read_u32(&char_size) && char_size == sizeof(pal::char_t) &&
+        reader.read_string(&root) && root == m_root &&
+        reader.read_count(&count);
+    if (valid)
+    {
+        m_stamps.resize(count);
+        for (auto& entry : m_stamps)
+        {
+            uint64_t mtime;
+            if (!reader.read_string(&entry.path) || !reader.read_u64(&entry.stamp.size) || !reader.read_u64(&mtime))
+            {
+                valid = false;
+                break;
+            }
+            entry.stamp.mtime = (int64_t) mtime;
+        }
+    }
+    valid = valid && reader.read_strings(&m_packages) && reader.at_end();
+    if (!valid)
+    {
+        trace::verbose(_X("Ignoring the servicing index [%s] as it could not be read"), cache_file.c_str());
+        m_stamps.clear();
+        m_packages.clear();
+    }
+    return valid;
+}
+
+bool servicing_index_t::write(const pal::string_t& cache_file) const
+{
+    std::string bytes;
+    binary_writer_t writer(&bytes);
+
+    writer.write_u32(s_index_magic);
+    writer.write_u32(s_index_version);
+    writer.write_u32(sizeof(pal::char_t));
+    writer.write_string(m_root);
+
+    writer.write_u32((uint32_t) m_stamps.size());
+    for (const auto& entry : m_stamps)
+    {
+        writer.write_string(entry.path);
+        writer.write_u64(entry.stamp.size);
+        writer.write_u64((uint64_t) entry.stamp.mtime);
+    }
+    writer.write_strings(m_packages);
+
+    return write_file_atomically(cache_file, bytes);
+}
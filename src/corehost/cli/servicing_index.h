@@ -0,0 +1,46 @@
+// Copyright (c) .NET Foundation and contributors. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef __SERVICING_INDEX_H_
+#define __SERVICING_INDEX_H_
+
+#include <vector>
+#include "pal.h"
+
+// The set of package versions in a servicing store, so that entries that are
+// not serviced are not probed there at all.
+//
+// The set is read with one walk of the package and version directories of the
+// store. If there is a host cache directory, it is cached there against the
+// stamps of the store directories and the walk is only repeated when one of
+// them changed.
+class servicing_index_t
+{
+public:
+    // Read the index of the servicing store at "root".
+    void load(const pal::string_t& root);
+
+    // Whether the store has the version "version" of package "name".
+    bool contains(const pal::string_t& name, const pal::string_t& version) const;
+
+    // The directories the package versions were read from.
+    void get_dirs(std::vector<pal::string_t>* dirs) const;
+
+private:
+    struct dir_stamp_t
+    {
+        pal::string_t path;
+        pal::file_stamp_t stamp;
+    };
+
+    bool read(const pal::string_t& cache_file);
+    bool write(const pal::string_t& cache_file) const;
+    void walk(bool stamp);
+    bool is_current() const;
+
+    pal::string_t m_root;
+    std::vector<dir_stamp_t> m_stamps;
+    std::vector<pal::string_t> m_packages; // Sorted "<name>/<version>" keys.
+};
+
+#endif // __SERVICING_INDEX_H_
@@ -17,6 +17,7 @@
 #include <memory>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 
 #if defined(_WIN32)
 
@@ -94,6 +95,7 @@ namespace pal
     // converts them to wchar in code for Windows. This line should become:
     // typedef std::basic_ifstream<pal::char_t> ifstream_t.
     typedef std::basic_ifstream<char> ifstream_t;
+    typedef std::basic_ofstream<char> ofstream_t;
     typedef std::istreambuf_iterator<ifstream_t::char_type> istreambuf_iterator_t;
     typedef HRESULT hresult_t;
     typedef HMODULE dll_t;
@@ -121,6 +123,7 @@ namespace pal
     bool utf8_palstring(const std::string& str, pal::string_t* out);
     bool pal_clrstring(const pal::string_t& str, std::vector<char>* out);
     bool clr_palstring(const char* cstr, pal::string_t* out);
+    inline const char* pal_clrcstr(const pal::string_t& str, std::vector<char>* buffer) { pal_clrstring(str, buffer); return buffer->data(); }
 #else
     #ifdef COREHOST_MAKE_DLL
         #define SHARED_API extern "C"
@@ -137,6 +140,7 @@ namespace pal
     typedef std::string string_t;
     typedef std::stringstream stringstream_t;
     typedef std::basic_ifstream<char> ifstream_t;
+    typedef std::basic_ofstream<char> ofstream_t;
     typedef std::istreambuf_iterator<ifstream_t::char_type> istreambuf_iterator_t;
     typedef int hresult_t;
     typedef void* dll_t;
@@ -163,14 +167,54 @@ namespace pal
     inline bool utf8_palstring(const std::string& str, pal::string_t* out) { out->assign(str); return true; }
     inline bool pal_clrstring(const pal::string_t& str, std::vector<char>* out) { out->assign(str.begin(), str.end()); out->push_back('\0'); return true; }
     inline bool clr_palstring(const char* cstr, pal::string_t* out) { out->assign(cstr); return true; }
+    inline const char* pal_clrcstr(const pal::string_t& str, std::vector<char>* /*buffer*/) { return str.c_str(); }
 #endif
 
+    // The size and last write time of a file or directory, to tell cheaply
+    // whether it changed since it was last looked at.
+    struct file_stamp_t
+    {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t id; // The inode, where the file system has one, or 0.
+    };
+
     bool touch_file(const pal::string_t& path);
+
+    // The file system calls made by the calling thread so far.
+    struct io_counters_t
+    {
+        uint64_t stats;   // Queries of a single path.
+        uint64_t dirs;    // Directory listings.
+        uint64_t opens;   // Files opened.
+        uint64_t batches; // Batches of queries.
+    };
+    io_counters_t& get_io_counters();
+    bool rename(const string_t& old_path, const string_t& new_path);
+    bool remove(const string_t& path);
+    int get_pid();
     bool realpath(string_t* path);
     bool file_exists(const string_t& path);
+    bool get_file_stamp(const string_t& path, file_stamp_t* stamp);
+    bool get_file_age(const string_t& path, int64_t* seconds); // Since it was last written.
+    bool map_file(const string_t& path, const char** data, size_t* size);
+    void unmap_file(const char* data, size_t size);
     inline bool directory_exists(const string_t& path) { return file_exists(path); }
     void readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list);
     void readdir(const string_t& path, std::vector<pal::string_t>* list);
+    bool list_dir(const string_t& path, std::vector<pal::string_t>* names);
+
+    // An entry of a directory, telling directories and links apart.
+    struct dir_entry_t
+    {
+        string_t name;
+        bool is_dir;  // A directory, or a link to one.
+        bool is_link;
+    };
+    bool list_dir(const string_t& path, std::vector<dir_entry_t>* entries);
+    bool is_batch_io_supported();
+    bool file_exists_batch(const std::vector<string_t>& paths, std::vector<bool>* exists);
+    void get_file_stamps(const std::vector<string_t>& paths, std::vector<file_stamp_t>* stamps, std::vector<bool>* exists);
 
     bool get_own_executable_path(string_t* recv);
     bool getenv(const char_t* name, string_t* recv);
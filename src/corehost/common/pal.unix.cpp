@@ -14,17 +14,49 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <fnmatch.h>
+#include <sys/mman.h>
+#include <climits>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <mutex>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
 #endif
 
+// io_uring batches the file system queries of a resolution. It is only built
+// with headers that have IORING_OP_STATX and IORING_REGISTER_PROBE, which came
+// with IORING_FEAT_RW_CUR_POS, and is called through raw syscalls.
+#if defined(__LINUX__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define FEATURE_IO_URING 1
+#endif
+#endif
+#endif
+
 #if defined(__LINUX__)
 #define symlinkEntrypointExecutable "/proc/self/exe"
 #elif !defined(__APPLE__)
 #define symlinkEntrypointExecutable "/proc/curproc/exe"
 #endif
 
+namespace
+{
+thread_local pal::io_counters_t s_io_counters;
+}
+
+pal::io_counters_t& pal::get_io_counters()
+{
+    return s_io_counters;
+}
+
 pal::string_t pal::to_string(int value) { return std::to_string(value); }
 
 pal::string_t pal::to_lower(const pal::string_t& in)
@@ -36,6 +68,7 @@ pal::string_t pal::to_lower(const pal::string_t& in)
 
 bool pal::touch_file(const pal::string_t& path)
 {
+    ++s_io_counters.opens;
     int fd = open(path.c_str(), (O_CREAT | O_EXCL), (S_IRUSR | S_IRGRP | S_IROTH));
     if (fd == -1)
     {
@@ -46,6 +79,21 @@ bool pal::touch_file(const pal::string_t& path)
     return true;
 }
 
+bool pal::rename(const pal::string_t& old_path, const pal::string_t& new_path)
+{
+    return ::rename(old_path.c_str(), new_path.c_str()) == 0;
+}
+
+bool pal::remove(const pal::string_t& path)
+{
+    return ::unlink(path.c_str()) == 0;
+}
+
+int pal::get_pid()
+{
+    return ::getpid();
+}
+
 bool pal::getcwd(pal::string_t* recv)
 {
     recv->clear();
@@ -228,10 +276,176 @@ bool pal::getenv(const pal::char_t* name, pal::string_t* recv)
     return (recv->length() > 0);
 }
 
+namespace
+{
+#if defined(MAXSYMLINKS)
+const int s_max_symlinks = MAXSYMLINKS;
+#else
+const int s_max_symlinks = 40;
+#endif
+
+// A path component already looked at by realpath, and the target if it is a
+// symbolic link.
+struct path_component_t
+{
+    enum kind_t
+    {
+        directory,
+        file,
+        link
+    };
+
+    kind_t kind;
+    pal::string_t target;
+};
+
+// Path components by their path, with every prefix already canonical. The host
+// resolves thousands of files under a few roots, and only needs to look at
+// each of their directories once.
+std::mutex s_path_components_lock;
+std::unordered_map<pal::string_t, path_component_t> s_path_components;
+
+bool find_path_component(const pal::string_t& path, path_component_t* component)
+{
+    std::lock_guard<std::mutex> lock(s_path_components_lock);
+    auto iter = s_path_components.find(path);
+    if (iter == s_path_components.end())
+    {
+        return false;
+    }
+    *component = iter->second;
+    return true;
+}
+
+void add_path_component(const pal::string_t& path, const path_component_t& component)
+{
+    std::lock_guard<std::mutex> lock(s_path_components_lock);
+    s_path_components.emplace(path, component);
+}
+
+// -----------------------------------------------------------------------------
+// Canonicalize "path" one component at a time, as libc realpath does, except
+// that directories and symbolic links seen before are not looked at again.
+// Sets errno on failure.
+//
+bool resolve_path(const pal::string_t& path, pal::string_t* resolved)
+{
+    if (path.empty())
+    {
+        errno = ENOENT;
+        return false;
+    }
+
+    pal::string_t pending;
+    if (path[0] != '/')
+    {
+        char cwd[PATH_MAX];
+        if (::getcwd(cwd, sizeof(cwd)) == nullptr)
+        {
+            return false;
+        }
+        pending.assign(cwd);
+        pending.push_back('/');
+    }
+    pending.append(path);
+
+    resolved->clear();
+    int links = 0;
+    size_t pos = 0;
+    while (pos < pending.length())
+    {
+        size_t end = pending.find('/', pos);
+        if (end == pal::string_t::npos)
+        {
+            end = pending.length();
+        }
+        pal::string_t name = pending.substr(pos, end - pos);
+        bool last = (end == pending.length());
+        pos = end + 1;
+
+        if (name.empty() || name == ".")
+        {
+            continue;
+        }
+        if (name == "..")
+        {
+            resolved->erase(std::min(resolved->length(), resolved->find_last_of('/')));
+            continue;
+        }
+
+        pal::string_t candidate = *resolved + "/" + name;
+        path_component_t component;
+        if (!find_path_component(candidate, &component))
+        {
+            struct stat buffer;
+            ++s_io_counters.stats;
+            if (::lstat(candidate.c_str(), &buffer) != 0)
+            {
+                return false;
+            }
+            if (S_ISLNK(buffer.st_mode))
+            {
+                char target[PATH_MAX];
+                ++s_io_counters.stats;
+                ssize_t size = ::readlink(candidate.c_str(), target, sizeof(target));
+                if (size < 0)
+                {
+                    return false;
+                }
+                if ((size_t) size >= sizeof(target))
+                {
+                    errno = ENAMETOOLONG;
+                    return false;
+                }
+                component.kind = path_component_t::link;
+                component.target.assign(target, size);
+            }
+            else
+            {
+                component.kind = S_ISDIR(buffer.st_mode) ? path_component_t::directory : path_component_t::file;
+            }
+            add_path_component(candidate, component);
+        }
+
+        if (component.kind == path_component_t::file && !last)
+        {
+            errno = ENOTDIR;
+            return false;
+        }
+        if (component.kind != path_component_t::link)
+        {
+            resolved->swap(candidate);
+            continue;
+        }
+
+        if (++links > s_max_symlinks)
+        {
+            errno = ELOOP;
+            return false;
+        }
+
+        // Resolve the target in place of the link, then the rest of the path.
+        if (!component.target.empty() && component.target[0] == '/')
+        {
+            resolved->clear();
+        }
+        pal::string_t rest = last ? pal::string_t() : "/" + pending.substr(pos);
+        pending = component.target + rest;
+        pos = 0;
+    }
+
+    if (resolved->empty())
+    {
+        resolved->assign("/");
+    }
+    return true;
+}
+} // end of anonymous namespace
+
 bool pal::realpath(pal::string_t* path)
 {
-    auto resolved = ::realpath(path->c_str(), nullptr);
-    if (resolved == nullptr)
+    pal::string_t resolved;
+    if (!resolve_path(*path, &resolved))
     {
         if (errno == ENOENT)
         {
@@ -240,8 +454,7 @@ bool pal::realpath(pal::string_t* path)
         perror("realpath()");
         return false;
     }
-    path->assign(resolved);
-    ::free(resolved);
+    path->swap(resolved);
     return true;
 }
 
@@ -252,15 +465,86 @@ bool pal::file_exists(const pal::string_t& path)
         return false;
     }
     struct stat buffer;
+    ++s_io_counters.stats;
     return (::stat(path.c_str(), &buffer) == 0);
 }
 
+bool pal::get_file_stamp(const pal::string_t& path, pal::file_stamp_t* stamp)
+{
+    struct stat buffer;
+    ++s_io_counters.stats;
+    if (path.empty() || ::stat(path.c_str(), &buffer) != 0)
+    {
+        return false;
+    }
+    stamp->size = (uint64_t) buffer.st_size;
+    stamp->id = (uint64_t) buffer.st_ino;
+#if defined(__APPLE__)
+    stamp->mtime = (int64_t) buffer.st_mtimespec.tv_sec * 1000000000 + buffer.st_mtimespec.tv_nsec;
+#else
+    stamp->mtime = (int64_t) buffer.st_mtim.tv_sec * 1000000000 + buffer.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+bool pal::get_file_age(const pal::string_t& path, int64_t* seconds)
+{
+    struct stat buffer;
+    ++s_io_counters.stats;
+    if (path.empty() || ::stat(path.c_str(), &buffer) != 0)
+    {
+        return false;
+    }
+    *seconds = (int64_t) ::time(nullptr) - (int64_t) buffer.st_mtime;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Map the contents of a file into memory, read only.
+//
+// Returns:
+//    False if the file could not be mapped or is empty.
+//
+bool pal::map_file(const pal::string_t& path, const char** data, size_t* size)
+{
+    ++s_io_counters.opens;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    struct stat buffer;
+    if (::fstat(fd, &buffer) != 0 || buffer.st_size <= 0)
+    {
+        (void) close(fd);
+        return false;
+    }
+
+    void* addr = ::mmap(nullptr, (size_t) buffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    (void) close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+
+    *data = static_cast<const char*>(addr);
+    *size = (size_t) buffer.st_size;
+    return true;
+}
+
+void pal::unmap_file(const char* data, size_t size)
+{
+    (void) ::munmap(const_cast<char*>(data), size);
+}
+
 void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
 {
     assert(list != nullptr);
 
     std::vector<pal::string_t>& files = *list;
 
+    ++s_io_counters.dirs;
     auto dir = opendir(path.c_str());
     if (dir != nullptr)
     {
@@ -290,6 +574,7 @@ void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal
                     fullFilename.append(entry->d_name);
 
                     struct stat sb;
+                    ++s_io_counters.stats;
                     if (stat(fullFilename.c_str(), &sb) == -1)
                     {
                         continue;
@@ -315,3 +600,524 @@ void pal::readdir(const pal::string_t& path, std::vector<pal::string_t>* list)
 {
     readdir(path, _X("*"), list);
 }
+
+// -----------------------------------------------------------------------------
+// List the names of the entries in a directory that file_exists would find.
+// Unlike readdir, the entries are not filtered by type, so only symlinks and
+// entries of unknown type are stat-ed, to leave out dangling links.
+//
+// Returns:
+//    False if the directory could not be opened.
+//
+bool pal::list_dir(const pal::string_t& path, std::vector<pal::string_t>* names)
+{
+    ++s_io_counters.dirs;
+    auto dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return false;
+    }
+
+    struct dirent* entry = nullptr;
+    while ((entry = ::readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.' &&
+            (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
+        {
+            continue;
+        }
+
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN)
+        {
+            pal::string_t full_path = path;
+            full_path.push_back(DIR_SEPARATOR);
+            full_path.append(entry->d_name);
+
+            struct stat sb;
+            ++s_io_counters.stats;
+            if (::stat(full_path.c_str(), &sb) == -1)
+            {
+                continue;
+            }
+        }
+
+        names->push_back(pal::string_t(entry->d_name));
+    }
+    closedir(dir);
+    return true;
+}
+
+bool pal::list_dir(const pal::string_t& path, std::vector<pal::dir_entry_t>* entries)
+{
+    ++s_io_counters.dirs;
+    auto dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return false;
+    }
+
+    struct dirent* entry = nullptr;
+    while ((entry = ::readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.' &&
+            (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
+        {
+            continue;
+        }
+
+        pal::dir_entry_t dir_entry;
+        dir_entry.is_dir = (entry->d_type == DT_DIR);
+        dir_entry.is_link = (entry->d_type == DT_LNK);
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN)
+        {
+            pal::string_t full_path = path;
+            full_path.push_back(DIR_SEPARATOR);
+            full_path.append(entry->d_name);
+
+            struct stat sb;
+            ++s_io_counters.stats;
+            if (entry->d_type == DT_UNKNOWN)
+            {
+                if (::lstat(full_path.c_str(), &sb) == -1)
+                {
+                    continue;
+                }
+                dir_entry.is_link = S_ISLNK(sb.st_mode);
+            }
+            if (dir_entry.is_link)
+            {
+                ++s_io_counters.stats;
+                if (::stat(full_path.c_str(), &sb) == -1)
+                {
+                    continue;
+                }
+            }
+            dir_entry.is_dir = S_ISDIR(sb.st_mode);
+        }
+
+        dir_entry.name.assign(entry->d_name);
+        entries->push_back(std::move(dir_entry));
+    }
+    closedir(dir);
+    return true;
+}
+
+#if defined(FEATURE_IO_URING)
+namespace
+{
+// The statx mask for the type of a file, from <linux/stat.h>, which is not
+// included as it conflicts with the statx declarations of glibc.
+const unsigned int s_statx_type = 0x00000001U;
+
+// The statx mask for the fields of a file stamp: the type, the mtime, the
+// inode and the size.
+const unsigned int s_statx_stamp = 0x00000341U;
+
+// The size of struct statx, which the kernel fills in.
+const size_t s_statx_size = 256;
+
+// The start of struct statx, up to the fields of a file stamp.
+struct statx_time_t
+{
+    int64_t sec;
+    uint32_t nsec;
+    int32_t reserved;
+};
+
+struct statx_head_t
+{
+    uint32_t mask;
+    uint32_t blksize;
+    uint64_t attributes;
+    uint32_t nlink;
+    uint32_t uid;
+    uint32_t gid;
+    uint16_t mode;
+    uint16_t spare;
+    uint64_t ino;
+    uint64_t size;
+    uint64_t blocks;
+    uint64_t attributes_mask;
+    statx_time_t atime;
+    statx_time_t btime;
+    statx_time_t ctime;
+    statx_time_t mtime;
+};
+static_assert(sizeof(statx_head_t) <= s_statx_size, "struct statx is 256 bytes");
+
+// -----------------------------------------------------------------------------
+// A submission and a completion queue mapped from the kernel, used by one
+// thread at a time.
+//
+// The ring owns the paths and the buffers of its batches. A batch that fails
+// may still be completed by the kernel, so the ring is then broken and never
+// used again, and its memory is kept for the kernel to write to.
+//
+class io_uring_t
+{
+public:
+    io_uring_t()
+        : m_broken(false)
+        , m_fd(-1)
+        , m_sq_ring(nullptr)
+        , m_sq_ring_size(0)
+        , m_cq_ring(nullptr)
+        , m_cq_ring_size(0)
+        , m_sqes(nullptr)
+        , m_sqes_size(0)
+    {
+    }
+
+    ~io_uring_t()
+    {
+        if (m_sqes != nullptr)
+        {
+            ::munmap(m_sqes, m_sqes_size);
+        }
+        if (m_cq_ring != nullptr && m_cq_ring != m_sq_ring)
+        {
+            ::munmap(m_cq_ring, m_cq_ring_size);
+        }
+        if (m_sq_ring != nullptr)
+        {
+            ::munmap(m_sq_ring, m_sq_ring_size);
+        }
+        if (m_fd != -1)
+        {
+            ::close(m_fd);
+        }
+    }
+
+    // Fails if io_uring is not supported by the kernel or is blocked, such as
+    // by seccomp, or if the kernel has it without IORING_OP_STATX.
+    bool setup(unsigned int entries)
+    {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_fd = (int) ::syscall(__NR_io_uring_setup, entries, &params);
+        if (m_fd < 0)
+        {
+            m_fd = -1;
+            return false;
+        }
+        m_params = params;
+        if (!supports_statx())
+        {
+            return false;
+        }
+
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+
+        m_sq_ring = map(m_sq_ring_size, IORING_OFF_SQ_RING);
+        if (m_sq_ring == nullptr)
+        {
+            return false;
+        }
+        m_cq_ring = single_mmap ? m_sq_ring : map(m_cq_ring_size, IORING_OFF_CQ_RING);
+        if (m_cq_ring == nullptr)
+        {
+            return false;
+        }
+        m_sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        m_sqes = map(m_sqes_size, IORING_OFF_SQES);
+        if (m_sqes == nullptr)
+        {
+            return false;
+        }
+        m_buffers.resize(this->entries() * s_statx_size);
+        return true;
+    }
+
+    unsigned int entries() const
+    {
+        return std::min(m_params.sq_entries, m_params.cq_entries);
+    }
+
+    // The struct statx of the path "i" of the last batch.
+    const char* buffer(size_t i) const
+    {
+        return m_buffers.data() + i * s_statx_size;
+    }
+
+    // Stat the paths, which must fit in the queues, following links as stat
+    // does. The result of each path is 0 or a negated errno.
+    bool statx(const std::vector<const char*>& paths, unsigned int mask, std::vector<int>* results)
+    {
+        assert(!m_broken && paths.size() <= entries());
+
+        // The kernel may read the paths after they are submitted.
+        std::vector<size_t> offsets;
+        m_paths.clear();
+        for (const char* path : paths)
+        {
+            offsets.push_back(m_paths.size());
+            m_paths.insert(m_paths.end(), path, path + strlen(path) + 1);
+        }
+
+        char* sq = static_cast<char*>(m_sq_ring);
+        unsigned int* sq_tail = reinterpret_cast<unsigned int*>(sq + m_params.sq_off.tail);
+        unsigned int sq_mask = *reinterpret_cast<unsigned int*>(sq + m_params.sq_off.ring_mask);
+        unsigned int* sq_array = reinterpret_cast<unsigned int*>(sq + m_params.sq_off.array);
+        struct io_uring_sqe* sqes = static_cast<struct io_uring_sqe*>(m_sqes);
+
+        unsigned int tail = *sq_tail;
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            unsigned int index = (tail + i) & sq_mask;
+            struct io_uring_sqe* sqe = &sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (uint64_t) (uintptr_t) (m_paths.data() + offsets[i]);
+            sqe->len = mask;
+            sqe->off = (uint64_t) (uintptr_t) (m_buffers.data() + i * s_statx_size);
+            sqe->statx_flags = 0;
+            sqe->user_data = i;
+            sq_array[index] = index;
+        }
+        __atomic_store_n(sq_tail, tail + (unsigned int) paths.size(), __ATOMIC_RELEASE);
+
+        char* cq = static_cast<char*>(m_cq_ring);
+        unsigned int* cq_head = reinterpret_cast<unsigned int*>(cq + m_params.cq_off.head);
+        unsigned int* cq_tail = reinterpret_cast<unsigned int*>(cq + m_params.cq_off.tail);
+        unsigned int cq_mask = *reinterpret_cast<unsigned int*>(cq + m_params.cq_off.ring_mask);
+        struct io_uring_cqe* cqes = reinterpret_cast<struct io_uring_cqe*>(cq + m_params.cq_off.cqes);
+
+        results->assign(paths.size(), -EAGAIN);
+        size_t submitted = 0;
+        size_t completed = 0;
+        while (completed < paths.size())
+        {
+            ++s_io_counters.batches;
+            int entered = (int) ::syscall(__NR_io_uring_enter, m_fd, (unsigned int) (paths.size() - submitted), 1U, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (entered < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                m_broken = true;
+                return false;
+            }
+            submitted += entered;
+
+            unsigned int head = *cq_head;
+            unsigned int ready = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != ready; ++head)
+            {
+                const struct io_uring_cqe& cqe = cqes[head & cq_mask];
+                if (cqe.user_data < results->size())
+                {
+                    (*results)[cqe.user_data] = cqe.res;
+                    ++completed;
+                }
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+
+private:
+    // Kernels from 5.1 to 5.5 have io_uring but complete IORING_OP_STATX with
+    // -EINVAL, and have no IORING_REGISTER_PROBE either.
+    bool supports_statx()
+    {
+        const unsigned int ops = 256;
+        std::vector<char> buffer(sizeof(struct io_uring_probe) + ops * sizeof(struct io_uring_probe_op));
+        struct io_uring_probe* probe = reinterpret_cast<struct io_uring_probe*>(buffer.data());
+        if (::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, ops) < 0)
+        {
+            return false;
+        }
+        return probe->last_op >= IORING_OP_STATX && probe->ops_len > IORING_OP_STATX &&
+            (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    void* map(size_t size, off_t offset)
+    {
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        return (addr == MAP_FAILED) ? nullptr : addr;
+    }
+
+    bool m_broken;
+    std::vector<char> m_paths;
+    std::vector<char> m_buffers;
+    int m_fd;
+    struct io_uring_params m_params;
+    void* m_sq_ring;
+    size_t m_sq_ring_size;
+    void* m_cq_ring;
+    size_t m_cq_ring_size;
+    void* m_sqes;
+    size_t m_sqes_size;
+};
+
+const unsigned int s_io_uring_entries = 256;
+
+// The ring of the process, set up on first use and used under the lock. It is
+// never torn down, so that no batch is in flight when its memory is freed,
+// even at exit.
+//
+// Whether io_uring could be set up: 1 if so, 0 if not or if it failed since,
+// -1 if not tried yet.
+int s_io_uring_state = -1;
+io_uring_t* s_io_uring = nullptr;
+std::mutex s_io_uring_lock;
+
+// The ring, if io_uring can be used. The lock must be held.
+io_uring_t* get_io_uring()
+{
+    if (s_io_uring_state == -1)
+    {
+        std::unique_ptr<io_uring_t> ring(new io_uring_t());
+        s_io_uring_state = ring->setup(s_io_uring_entries) ? 1 : 0;
+        if (s_io_uring_state == 1)
+        {
+            s_io_uring = ring.release();
+        }
+        else
+        {
+            trace::verbose(_X("io_uring is not available, the file system is queried one path at a time"));
+        }
+    }
+    return (s_io_uring_state == 1) ? s_io_uring : nullptr;
+}
+} // end of anonymous namespace
+#endif // FEATURE_IO_URING
+
+// -----------------------------------------------------------------------------
+// Whether the file system can be queried in batches, which is tried once for
+// the process. io_uring may be missing from the kernel or blocked by seccomp.
+//
+bool pal::is_batch_io_supported()
+{
+#if defined(FEATURE_IO_URING)
+    std::lock_guard<std::mutex> lock(s_io_uring_lock);
+    return get_io_uring() != nullptr;
+#else
+    return false;
+#endif
+}
+
+#if defined(FEATURE_IO_URING)
+namespace
+{
+// -----------------------------------------------------------------------------
+// Stat the paths in batches with io_uring, asking for the fields in "mask",
+// and pass the result of each, 0 or a negated errno, and its struct statx to
+// "on_result".
+//
+// Returns:
+//    False if the file system cannot be queried in batches, in which case
+//    some of the paths may have been passed to "on_result" already.
+//
+bool statx_paths(const std::vector<pal::string_t>& paths, unsigned int mask, const std::function<void(size_t, int, const char*)>& on_result)
+{
+    std::lock_guard<std::mutex> lock(s_io_uring_lock);
+    io_uring_t* ring = get_io_uring();
+    if (ring == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<const char*> batch;
+    std::vector<int> results;
+    for (size_t start = 0; start < paths.size(); start += batch.size())
+    {
+        batch.clear();
+        for (size_t i = start; i < paths.size() && batch.size() < ring->entries(); ++i)
+        {
+            batch.push_back(paths[i].c_str());
+        }
+        if (!ring->statx(batch, mask, &results))
+        {
+            trace::verbose(_X("io_uring failed, the file system is queried one path at a time from now on"));
+            s_io_uring_state = 0;
+            return false;
+        }
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            on_result(start + i, results[i], ring->buffer(i));
+        }
+    }
+    return true;
+}
+
+// Whether a statx result is an answer about the path itself, rather than a
+// failure such as a path too long for the kernel to take.
+bool is_statx_answer(int result)
+{
+    return result == 0 || result == -ENOENT || result == -ENOTDIR;
+}
+} // end of anonymous namespace
+#endif // FEATURE_IO_URING
+
+// -----------------------------------------------------------------------------
+// Whether the files exist, as file_exists would answer, looked at in batches
+// with io_uring.
+//
+// Returns:
+//    False if the file system cannot be queried in batches. The callers then
+//    use file_exists as they would have.
+//
+bool pal::file_exists_batch(const std::vector<pal::string_t>& paths, std::vector<bool>* exists)
+{
+#if defined(FEATURE_IO_URING)
+    exists->assign(paths.size(), false);
+    return statx_paths(paths, s_statx_type, [&paths, exists](size_t i, int result, const char*)
+    {
+        (*exists)[i] = is_statx_answer(result) ? (result == 0) : pal::file_exists(paths[i]);
+    });
+#else
+    return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// The stamps of the files, as get_file_stamp would read them, read in batches
+// with io_uring where it is available and one by one otherwise.
+//
+void pal::get_file_stamps(const std::vector<pal::string_t>& paths, std::vector<pal::file_stamp_t>* stamps, std::vector<bool>* exists)
+{
+    pal::file_stamp_t none;
+    none.size = 0;
+    none.mtime = 0;
+    none.id = 0;
+    stamps->assign(paths.size(), none);
+    exists->assign(paths.size(), false);
+
+#if defined(FEATURE_IO_URING)
+    auto on_result = [&paths, stamps, exists](size_t i, int result, const char* buffer)
+    {
+        if (!is_statx_answer(result))
+        {
+            (*exists)[i] = pal::get_file_stamp(paths[i], &(*stamps)[i]);
+            return;
+        }
+        if (result == 0)
+        {
+            statx_head_t head;
+            memcpy(&head, buffer, sizeof(head));
+            (*stamps)[i].size = head.size;
+            (*stamps)[i].mtime = head.mtime.sec * 1000000000 + head.mtime.nsec;
+            (*stamps)[i].id = head.ino;
+            (*exists)[i] = true;
+        }
+    };
+    if (statx_paths(paths, s_statx_stamp, on_result))
+    {
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        (*exists)[i] = pal::get_file_stamp(paths[i], &(*stamps)[i]);
+    }
+}
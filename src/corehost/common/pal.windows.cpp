@@ -22,6 +22,16 @@ pal::string_t pal::to_string(int value)
     return std::to_wstring(value);
 }
 
+namespace
+{
+thread_local pal::io_counters_t s_io_counters;
+}
+
+pal::io_counters_t& pal::get_io_counters()
+{
+    return s_io_counters;
+}
+
 bool pal::find_coreclr(pal::string_t* recv)
 {
     pal::string_t candidate;
@@ -55,6 +65,7 @@ bool pal::find_coreclr(pal::string_t* recv)
 
 bool pal::touch_file(const pal::string_t& path)
 {
+    ++s_io_counters.opens;
     HANDLE hnd = ::CreateFileW(path.c_str(), 0, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
     if (hnd == INVALID_HANDLE_VALUE)
     {
@@ -65,6 +76,21 @@ bool pal::touch_file(const pal::string_t& path)
     return true;
 }
 
+bool pal::rename(const pal::string_t& old_path, const pal::string_t& new_path)
+{
+    return ::MoveFileExW(old_path.c_str(), new_path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+bool pal::remove(const pal::string_t& path)
+{
+    return ::DeleteFileW(path.c_str()) != FALSE;
+}
+
+int pal::get_pid()
+{
+    return (int) ::GetCurrentProcessId();
+}
+
 void pal::setup_api_sets(const std::unordered_set<pal::string_t>& api_sets)
 {
     if (api_sets.empty())
@@ -310,12 +336,83 @@ bool pal::file_exists(const string_t& path)
     }
 
     WIN32_FIND_DATAW data;
+    ++s_io_counters.stats;
     auto find_handle = ::FindFirstFileW(path.c_str(), &data);
     bool found = find_handle != INVALID_HANDLE_VALUE;
     ::FindClose(find_handle);
     return found;
 }
 
+bool pal::get_file_stamp(const string_t& path, file_stamp_t* stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    ++s_io_counters.stats;
+    if (path.empty() || !::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+    {
+        return false;
+    }
+    stamp->size = ((uint64_t) data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    stamp->mtime = (int64_t) (((uint64_t) data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime);
+    stamp->id = 0; // Not read, as it takes opening the file.
+    return true;
+}
+
+bool pal::get_file_age(const string_t& path, int64_t* seconds)
+{
+    file_stamp_t stamp;
+    if (!get_file_stamp(path, &stamp))
+    {
+        return false;
+    }
+
+    // File times are in 100ns units.
+    FILETIME now;
+    ::GetSystemTimeAsFileTime(&now);
+    int64_t now_time = (int64_t) (((uint64_t) now.dwHighDateTime << 32) | now.dwLowDateTime);
+    *seconds = (now_time - stamp.mtime) / 10000000;
+    return true;
+}
+
+bool pal::map_file(const string_t& path, const char** data, size_t* size)
+{
+    ++s_io_counters.opens;
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!::GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = ::CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    ::CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return false;
+    }
+
+    void* addr = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    ::CloseHandle(mapping);
+    if (addr == NULL)
+    {
+        return false;
+    }
+
+    *data = static_cast<const char*>(addr);
+    *size = (size_t) file_size.QuadPart;
+    return true;
+}
+
+void pal::unmap_file(const char* data, size_t size)
+{
+    ::UnmapViewOfFile(data);
+}
+
 void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal::string_t>* list)
 {
     assert(list != nullptr);
@@ -326,6 +423,7 @@ void pal::readdir(const string_t& path, const string_t& pattern, std::vector<pal
     append_path(&search_string, pattern.c_str());
 
     WIN32_FIND_DATAW data = { 0 };
+    ++s_io_counters.dirs;
     auto handle = ::FindFirstFileExW(search_string.c_str(), FindExInfoStandard, &data, FindExSearchNameMatch, NULL, 0);
     if (handle == INVALID_HANDLE_VALUE)
     {
@@ -343,3 +441,76 @@ void pal::readdir(const string_t& path, std::vector<pal::string_t>* list)
 {
     pal::readdir(path, _X("*"), list);
 }
+
+bool pal::list_dir(const string_t& path, std::vector<pal::string_t>* names)
+{
+    string_t search_string(path);
+    append_path(&search_string, _X("*"));
+
+    WIN32_FIND_DATAW data = { 0 };
+    ++s_io_counters.dirs;
+    auto handle = ::FindFirstFileExW(search_string.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, NULL, 0);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    do
+    {
+        if (::wcscmp(data.cFileName, L".") == 0 || ::wcscmp(data.cFileName, L"..") == 0)
+        {
+            continue;
+        }
+        names->push_back(string_t(data.cFileName));
+    } while (::FindNextFileW(handle, &data));
+    ::FindClose(handle);
+    return true;
+}
+
+bool pal::list_dir(const string_t& path, std::vector<pal::dir_entry_t>* entries)
+{
+    string_t search_string(path);
+    append_path(&search_string, _X("*"));
+
+    WIN32_FIND_DATAW data = { 0 };
+    ++s_io_counters.dirs;
+    auto handle = ::FindFirstFileExW(search_string.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, NULL, 0);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    do
+    {
+        if (::wcscmp(data.cFileName, L".") == 0 || ::wcscmp(data.cFileName, L"..") == 0)
+        {
+            continue;
+        }
+        pal::dir_entry_t entry;
+        entry.name.assign(data.cFileName);
+        entry.is_dir = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        entry.is_link = (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+        entries->push_back(std::move(entry));
+    } while (::FindNextFileW(handle, &data));
+    ::FindClose(handle);
+    return true;
+}
+
+bool pal::is_batch_io_supported()
+{
+    return false;
+}
+
+bool pal::file_exists_batch(const std::vector<string_t>& paths, std::vector<bool>* exists)
+{
+    return false;
+}
+
+void pal::get_file_stamps(const std::vector<string_t>& paths, std::vector<file_stamp_t>* stamps, std::vector<bool>* exists)
+{
+    file_stamp_t none = { 0, 0, 0 };
+    stamps->assign(paths.size(), none);
+    exists->assign(paths.size(), false);
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        (*exists)[i] = get_file_stamp(paths[i], &(*stamps)[i]);
+    }
+}
@@ -239,3 +239,55 @@ bool skip_utf8_bom(pal::ifstream_t* stream)
 
     return true;
 }
+
+// The directory the host keeps its caches in. Caching is opt-in: the
+// directory has to be specified with COREHOST_CACHE_DIR and has to exist.
+bool get_host_cache_dir(pal::string_t* dir)
+{
+    if (!pal::getenv(_X("COREHOST_CACHE_DIR"), dir) || dir->empty())
+    {
+        return false;
+    }
+    if (!pal::directory_exists(*dir))
+    {
+        trace::verbose(_X("Host cache directory [%s] does not exist"), dir->c_str());
+        return false;
+    }
+    return true;
+}
+
+// Write the file through a temporary file, so concurrent readers see either
+// the previous contents or the new contents but never a partial file. The
+// temporary file is removed if the write fails, so failing runs do not leave
+// one each behind.
+bool write_file_atomically(const pal::string_t& path, const std::string& bytes)
+{
+    pal::string_t temp_path = path + _X(".") + pal::to_string(pal::get_pid()) + _X(".tmp");
+    bool written = false;
+    {
+        pal::ofstream_t file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.good())
+        {
+            trace::verbose(_X("Could not create [%s]"), temp_path.c_str());
+            return false;
+        }
+        file.write(bytes.data(), bytes.size());
+        file.close();
+        written = !file.fail();
+    }
+    if (!written)
+    {
+        trace::verbose(_X("Could not write [%s]"), temp_path.c_str());
+    }
+    else if (!pal::rename(temp_path, path))
+    {
+        trace::verbose(_X("Could not rename [%s] to [%s]"), temp_path.c_str(), path.c_str());
+        written = false;
+    }
+
+    if (!written)
+    {
+        (void) pal::remove(temp_path);
+    }
+    return written;
+}
@@ -31,4 +31,6 @@ bool parse_known_args(
     std::unordered_map<pal::string_t, std::vector<pal::string_t>>* opts,
     int* num_args);
 bool skip_utf8_bom(pal::ifstream_t* stream);
+bool get_host_cache_dir(pal::string_t* dir);
+bool write_file_atomically(const pal::string_t& path, const std::string& bytes);
 #endif